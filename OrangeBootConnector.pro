@@ -4,36 +4,24 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
-QT       += serialport
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-TARGET = OrangeBootConnector
-TEMPLATE = app
-
-# The following define makes your compiler emit warnings if you use
-# any feature of Qt which has been marked as deprecated (the exact warnings
-# depend on your compiler). Please consult the documentation of the
-# deprecated API in order to know how to port your code away from it.
-DEFINES += QT_DEPRECATED_WARNINGS
-
-# You can also make your code fail to compile if you use deprecated APIs.
-# In order to do so, uncomment the following line.
-# You can also select to disable deprecated APIs only up to a certain version of Qt.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-
-SOURCES += \
-        main.cpp \
-        mainwindow.cpp \
-    crc32.cpp
-
-HEADERS += \
-        mainwindow.h \
-    crc32.h
-
-FORMS += \
-        mainwindow.ui
-
-RC_ICONS = logo.ico
+# core: 协议与烧写引擎 (静态库, 不依赖界面)
+# gui:  图形界面
+# cli:  命令行烧写工具
+# sim:  伪终端上的虚拟 bootloader (仅 Linux)
+# bench: 对 sim 的烧写性能测试 (仅 Linux)
+# tests: 单元测试 (make check)
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    core \
+    gui \
+    cli \
+    tests
+
+linux: SUBDIRS += sim bench
+
+gui.depends = core
+cli.depends = core
+tests.depends = core
+sim.depends = core
+bench.depends = core
@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# 烧写性能测试, 对伪终端上的虚拟 bootloader 运行 (仅 Linux)
+#
+#-------------------------------------------------
+
+QT       += core
+QT       += serialport
+QT       -= gui
+
+TARGET = OrangeBootBench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../core/core.pri)
+
+INCLUDEPATH += ../sim
+
+SOURCES += \
+        ../sim/ptysim.cpp \
+        benchrunner.cpp \
+        main.cpp
+
+HEADERS += \
+        ../sim/ptysim.h \
+        benchrunner.h
@@ -0,0 +1,206 @@
+#include "benchrunner.h"
+#include "ptysim.h"
+#include "protocol.h"
+#include <QCoreApplication>
+#include <QTimer>
+#include <algorithm>
+#include <random>
+#include <stdio.h>
+
+SimThread::SimThread(const BenchCase &c, int erase_ms, QObject *parent) :
+    QThread(parent),
+    bench(c)
+{
+    this->erase_ms = erase_ms;
+    ready = false;
+}
+
+/**
+* @brief  等待伪终端创建完成
+* @return 从设备名, 失败时为空
+*/
+QString SimThread::wait_ready(void)
+{
+    QMutexLocker locker(&lock);
+
+    while(!ready)
+        cond.wait(&lock);
+
+    return slave;
+}
+
+void SimThread::run(void)
+{
+    PtySim pty;
+    QString name;
+
+    pty.set_latency(bench.latency);
+    pty.set_erase_time(erase_ms);
+    pty.set_sector_erase_time(erase_ms);
+    pty.device()->set_caps((bench.lz_block > 0) ? PROTO_CAP_LZ : 0, bench.lz_block);
+    pty.device()->set_frame_max(bench.frame_max);
+
+    if(pty.open(QString()))
+        name = pty.slave_name();
+    else
+        fprintf(stderr, "%s\n", qPrintable(pty.error_string()));
+
+    lock.lock();
+    slave = name;
+    ready = true;
+    cond.wakeAll();
+    lock.unlock();
+
+    if(!name.isEmpty())
+        exec();
+}
+
+BenchRunner::BenchRunner(QObject *parent) :
+    QObject(parent)
+{
+    erase_ms = 20;
+    repeat = 1;
+    index = 0;
+    round = 0;
+    sim = NULL;
+    engine = NULL;
+}
+
+/**
+* @brief  生成测试固件: 前 5/8 为代码 (常用指令字重复出现, 夹杂少量随机字), 其余为 0xFF 填充
+* @note   固定随机种子, 各次运行的固件相同
+*/
+QByteArray BenchRunner::make_image(int size)
+{
+    std::mt19937 rng(1);
+    uint dict[64];
+    QByteArray data(size & ~3, (char)0xff);
+    int code = (size * 5 / 8) & ~3;
+
+    for(int i = 0; i < 64; i++)
+        dict[i] = rng();
+
+    for(int i = 0; i < code; i += 4)
+    {
+        uint r = rng();
+        uint w = ((r & 7) == 0) ? rng() : dict[(r >> 3) % ((r & 8) ? 8 : 64)];
+        memcpy(data.data() + i, &w, 4);
+    }
+
+    return data;
+}
+
+void BenchRunner::start(void)
+{
+    index = 0;
+    round = 0;
+    next();
+}
+
+/**
+ * @brief 开始下一组: 启动虚拟设备, 以复位后的波特率连接, 连接后协商到本组的波特率
+ */
+void BenchRunner::next(void)
+{
+    if(index >= cases.size())
+    {
+        QCoreApplication::exit(0);
+        return;
+    }
+
+    const BenchCase &c = cases.at(index);
+
+    sim = new SimThread(c, erase_ms, this);
+    sim->start();
+
+    QString slave = sim->wait_ready();
+    if(slave.isEmpty())
+    {
+        sim->wait();
+        QCoreApplication::exit(1);
+        return;
+    }
+
+    if(image.size() != c.size)
+        image = make_image(c.size);
+
+    engine = new FlashEngine(this);
+    connect(engine, &FlashEngine::finished, this, &BenchRunner::engine_finished);
+    engine->set_prog_window(c.window);
+    engine->set_max_baudrate((c.baud > SIM_BAUD_DEFAULT) ? c.baud : 0);
+    engine->open_device(slave, SIM_BAUD_DEFAULT);
+}
+
+void BenchRunner::engine_finished(int op, bool ok, QString msg)
+{
+    if((op == FlashEngine::OP_CONNECT) && ok)
+    {
+        connect_stats = engine->stats();
+        engine->program(image);
+        return;
+    }
+
+    if(op == FlashEngine::OP_CONNECT)
+        connect_stats = engine->stats();
+
+    report(ok, msg);
+
+    engine->close_device();
+    engine->deleteLater();
+    engine = NULL;
+
+    sim->quit();
+    sim->wait();
+    delete sim;
+    sim = NULL;
+
+    if(++round >= repeat)
+    {
+        round = 0;
+        index++;
+    }
+    QTimer::singleShot(0, this, &BenchRunner::next);
+}
+
+/**
+ * @brief 输出一行 JSON. 连接阶段取自连接操作, 其余取自烧写操作
+ */
+void BenchRunner::report(bool ok, const QString &msg)
+{
+    const BenchCase &c = cases.at(index);
+    const FlashEngine::Stats &s = engine->stats();
+    qint64 phase[FlashEngine::PHASE_NUM];
+    double total_ms = 0;
+
+    for(int i = 0; i < FlashEngine::PHASE_NUM; i++)
+    {
+        phase[i] = (i <= FlashEngine::PHASE_QUERY) ? connect_stats.phase_ns[i] : s.phase_ns[i];
+        total_ms += phase[i] / 1e6;
+    }
+
+    QVector<int> ack = s.ack_us;
+    std::sort(ack.begin(), ack.end());
+    int p50 = ack.isEmpty() ? 0 : ack.at(ack.size() / 2);
+    int p99 = ack.isEmpty() ? 0 : ack.at(qMin(ack.size() - 1, ack.size() * 99 / 100));
+
+    double prog_s = phase[FlashEngine::PHASE_PROGRAM] / 1e9;
+    double flash_s = (phase[FlashEngine::PHASE_ERASE] + phase[FlashEngine::PHASE_PROGRAM] + phase[FlashEngine::PHASE_CRC]) / 1e9;
+
+    printf("{\"size\":%d,\"baud\":%d,\"window\":%d,\"frame_max\":%d,\"lz_block\":%d,\"latency_us\":%d,\"round\":%d,\"ok\":%s,\"error\":\"%s\",",
+           c.size, c.baud, c.window, c.frame_max, c.lz_block, c.latency, round, ok ? "true" : "false",
+           qPrintable(QString(msg).replace('"', '\'')));
+
+    printf("\"phase_ms\":{");
+    for(int i = 0; i < FlashEngine::PHASE_NUM; i++)
+        printf("%s\"%s\":%.3f", (i > 0) ? "," : "", FlashEngine::phase_name(i), phase[i] / 1e6);
+    printf("},\"total_ms\":%.3f,", total_ms);
+
+    printf("\"frames\":%ld,\"data_bytes\":%ld,\"wire_bytes\":%ld,", s.frames, s.data_bytes, s.wire_bytes);
+    printf("\"bytes_per_s\":%.0f,\"wire_bytes_per_s\":%.0f,\"frames_per_s\":%.1f,\"effective_bytes_per_s\":%.0f,",
+           (prog_s > 0) ? s.data_bytes / prog_s : 0.0,
+           (prog_s > 0) ? s.wire_bytes / prog_s : 0.0,
+           (prog_s > 0) ? s.frames / prog_s : 0.0,
+           (ok && (flash_s > 0)) ? c.size / flash_s : 0.0);
+    printf("\"ack_p50_us\":%d,\"ack_p99_us\":%d}\n", p50, p99);
+    fflush(stdout);
+}
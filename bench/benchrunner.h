@@ -0,0 +1,85 @@
+#ifndef BENCHRUNNER_H
+#define BENCHRUNNER_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include "flashengine.h"
+
+/**
+ * @brief 一次测试的参数
+ */
+struct BenchCase
+{
+    int size;               /*!< 固件大小, 单位 byte */
+    int baud;               /*!< 协商到的波特率 */
+    int window;             /*!< 烧写滑动窗口 */
+    int frame_max;          /*!< 设备声明的最大数据帧长度, 为 0 时为不支持查询的旧设备 (252 字节) */
+    int lz_block;           /*!< 设备解压缓冲区, 为 0 时不使用压缩帧 */
+    int latency;            /*!< 设备处理每条指令的时间, 单位 us */
+};
+
+/**
+ * @brief 在独立线程中运行虚拟 bootloader, 使其计时不受主机一侧事件循环的影响
+ */
+class SimThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    SimThread(const BenchCase &c, int erase_ms, QObject *parent = 0);
+
+    QString wait_ready(void);
+
+protected:
+    void run(void);
+
+private:
+    BenchCase bench;
+    int erase_ms;
+    QMutex lock;
+    QWaitCondition cond;
+    bool ready;
+    QString slave;
+};
+
+/**
+ * @brief 依次运行各组参数: 连接, 烧写, 每组输出一行 JSON
+ */
+class BenchRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BenchRunner(QObject *parent = 0);
+
+    void add_case(const BenchCase &c) { cases.append(c); }
+    void set_erase_time(int ms) { erase_ms = ms; }
+    void set_repeat(int n) { repeat = n; }
+
+public slots:
+    void start(void);
+
+private slots:
+    void engine_finished(int op, bool ok, QString msg);
+
+private:
+    QVector<BenchCase> cases;
+    int erase_ms;
+    int repeat;
+    int index;
+    int round;
+
+    SimThread *sim;
+    FlashEngine *engine;
+    QByteArray image;
+    FlashEngine::Stats connect_stats;
+
+    void next(void);
+    void report(bool ok, const QString &msg);
+    static QByteArray make_image(int size);
+};
+
+#endif // BENCHRUNNER_H
@@ -0,0 +1,91 @@
+#include "benchrunner.h"
+#include "bootloadersim.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <stdio.h>
+
+/**
+* @brief  解析以逗号分隔的整数列表
+* @return 是否全部为正整数 (允许 0)
+*/
+static bool parse_list(const QString &text, QVector<int> *list)
+{
+    list->clear();
+    foreach(const QString &item, text.split(','))
+    {
+        bool ok;
+        int v = item.trimmed().toInt(&ok);
+        if(!ok || (v < 0))
+            return false;
+        list->append(v);
+    }
+
+    return !list->isEmpty();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCommandLineParser parser;
+    BenchRunner runner;
+
+    parser.setApplicationDescription("OrangeBoot flashing benchmark against a pty simulator, one JSON object per line");
+    parser.addHelpOption();
+
+    QCommandLineOption sizes_opt("sizes", "Image sizes in bytes.", "list", "65536,262144");
+    QCommandLineOption bauds_opt("bauds", "Baud rates negotiated after sync.", "list", "115200,921600");
+    QCommandLineOption windows_opt("windows", "Program windows.", "list", "1,4");
+    QCommandLineOption frame_opt("frame-sizes", "Largest frame payloads reported by the device, 0 for a legacy device (252 bytes).", "list", "0,4096");
+    QCommandLineOption lz_opt("lz-blocks", "Device decompression buffer sizes, 0 for no compressed frames.", "list", "0,4096");
+    QCommandLineOption latency_opt("latencies", "Device processing time per command in us.", "list", "50,500");
+    QCommandLineOption erase_opt("erase-time", "Simulated erase time in ms.", "ms", "20");
+    QCommandLineOption repeat_opt("repeat", "Runs per combination.", "n", "1");
+
+    parser.addOption(sizes_opt);
+    parser.addOption(bauds_opt);
+    parser.addOption(windows_opt);
+    parser.addOption(frame_opt);
+    parser.addOption(lz_opt);
+    parser.addOption(latency_opt);
+    parser.addOption(erase_opt);
+    parser.addOption(repeat_opt);
+    parser.process(a);
+
+    QVector<int> sizes, bauds, windows, frame_sizes, lz_blocks, latencies;
+    if(!parse_list(parser.value(sizes_opt), &sizes) || !parse_list(parser.value(bauds_opt), &bauds) ||
+       !parse_list(parser.value(windows_opt), &windows) || !parse_list(parser.value(frame_opt), &frame_sizes) ||
+       !parse_list(parser.value(lz_opt), &lz_blocks) ||
+       !parse_list(parser.value(latency_opt), &latencies))
+    {
+        fprintf(stderr, "invalid list\n");
+        return 1;
+    }
+
+    foreach(int size, sizes)
+    {
+        if(size > SIM_FW_SIZE)
+        {
+            fprintf(stderr, "image size %d exceeds the simulated firmware area (%d)\n", size, SIM_FW_SIZE);
+            return 1;
+        }
+    }
+
+    foreach(int size, sizes)
+        foreach(int baud, bauds)
+            foreach(int window, windows)
+                foreach(int frame_max, frame_sizes)
+                    foreach(int lz_block, lz_blocks)
+                        foreach(int latency, latencies)
+                        {
+                            BenchCase c = {size, baud, window, frame_max, lz_block, latency};
+                            runner.add_case(c);
+                        }
+
+    runner.set_erase_time(parser.value(erase_opt).toInt());
+    runner.set_repeat(qMax(1, parser.value(repeat_opt).toInt()));
+
+    QTimer::singleShot(0, &runner, SLOT(start()));
+
+    return a.exec();
+}
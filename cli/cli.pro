@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# 命令行烧写工具, 用于自动化治具
+#
+#-------------------------------------------------
+
+QT       += core
+QT       += serialport
+QT       -= gui
+
+TARGET = OrangeBootCli
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../core/core.pri)
+
+SOURCES += \
+        main.cpp \
+        flashcli.cpp
+
+HEADERS += \
+        flashcli.h
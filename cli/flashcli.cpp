@@ -0,0 +1,303 @@
+#include "flashcli.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <stdio.h>
+
+FlashCli::FlashCli(QObject *parent) :
+    QObject(parent)
+{
+    engine = new FlashEngine(this);
+
+    connect(engine, &FlashEngine::device_ready, this, &FlashCli::engine_device_ready);
+    connect(engine, &FlashEngine::progress, this, &FlashCli::engine_progress);
+    connect(engine, &FlashEngine::warning, this, &FlashCli::engine_warning);
+    connect(engine, &FlashEngine::finished, this, &FlashCli::engine_finished);
+
+    baudrate = 0;
+    show_info = false;
+    do_erase = false;
+    do_boot = false;
+    do_update = false;
+    last_percent = -1;
+}
+
+/**
+* @brief  解析命令行参数
+* @param  [in] arguments QStringList. 命令行参数
+* @return -1,继续执行.其他,以该退出码退出
+*/
+int FlashCli::parse(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("OrangeBoot command line flasher");
+    parser.addHelpOption();
+
+    QCommandLineOption port_opt(QStringList() << "p" << "port", "Serial port name.", "port");
+    QCommandLineOption baud_opt(QStringList() << "b" << "baud", "Baud rate, detected automatically if omitted.", "rate");
+    QCommandLineOption max_baud_opt("max-baud", "Highest baud rate to switch to after sync, 0 to keep the sync rate.", "rate");
+    QCommandLineOption window_opt(QStringList() << "w" << "window", "Program window, 1 for stop-and-wait.", "frames");
+    QCommandLineOption no_skip_opt("no-skip-blank", "Send all-0xFF frames instead of skipping them after erase.");
+    QCommandLineOption max_frame_opt("max-frame", "Largest program frame payload, 0 for what the device reports.", "bytes");
+    QCommandLineOption no_lz_opt("no-compress", "Send plain frames even if the device accepts compressed ones.");
+    QCommandLineOption no_resume_opt("no-resume", "Always erase and program from the start, ignoring a checkpoint from an interrupted run.");
+    QCommandLineOption info_opt(QStringList() << "i" << "info", "Print device information.");
+    QCommandLineOption erase_opt(QStringList() << "e" << "erase", "Erase the application area.");
+    QCommandLineOption flash_opt(QStringList() << "f" << "flash", "Erase, program and verify a firmware file.", "file");
+    QCommandLineOption update_opt(QStringList() << "u" << "update", "Program only the sectors that differ from a firmware file.", "file");
+    QCommandLineOption verify_opt("verify", "Verify the device against a firmware file.", "file");
+    QCommandLineOption boot_opt("boot", "Boot the application when done.");
+    QCommandLineOption trace_opt("trace", "Record every command and write a Chrome trace (chrome://tracing, Perfetto) on exit.", "file");
+
+    parser.addOption(port_opt);
+    parser.addOption(baud_opt);
+    parser.addOption(max_baud_opt);
+    parser.addOption(window_opt);
+    parser.addOption(no_skip_opt);
+    parser.addOption(max_frame_opt);
+    parser.addOption(no_lz_opt);
+    parser.addOption(no_resume_opt);
+    parser.addOption(info_opt);
+    parser.addOption(erase_opt);
+    parser.addOption(flash_opt);
+    parser.addOption(update_opt);
+    parser.addOption(verify_opt);
+    parser.addOption(boot_opt);
+    parser.addOption(trace_opt);
+
+    if(!parser.parse(arguments))
+    {
+        fprintf(stderr, "%s\n", qPrintable(parser.errorText()));
+        return EXIT_USAGE;
+    }
+
+    if(parser.isSet("help"))
+    {
+        printf("%s", qPrintable(parser.helpText()));
+        return EXIT_OK;
+    }
+
+    if(!parser.isSet(port_opt))
+    {
+        fprintf(stderr, "missing --port\n");
+        return EXIT_USAGE;
+    }
+
+    port_name = parser.value(port_opt);
+    baudrate = parser.value(baud_opt).toInt();
+    show_info = parser.isSet(info_opt);
+    do_erase = parser.isSet(erase_opt);
+    do_boot = parser.isSet(boot_opt);
+
+    if(parser.isSet(max_baud_opt))
+        engine->set_max_baudrate(parser.value(max_baud_opt).toInt());
+
+    if(parser.isSet(window_opt))
+        engine->set_prog_window(parser.value(window_opt).toInt());
+
+    if(parser.isSet(no_skip_opt))
+        engine->set_skip_blank(false);
+
+    if(parser.isSet(no_resume_opt))
+        engine->set_resume(false);
+
+    if(parser.isSet(max_frame_opt))
+        engine->set_max_frame(parser.value(max_frame_opt).toInt());
+
+    if(parser.isSet(no_lz_opt))
+        engine->set_compress(false);
+
+    trace_path = parser.value(trace_opt);
+    if(!trace_path.isEmpty())
+        engine->set_trace(true);
+
+    if(parser.isSet(flash_opt) && parser.isSet(update_opt))
+    {
+        fprintf(stderr, "--flash and --update are exclusive\n");
+        return EXIT_USAGE;
+    }
+
+    if(parser.isSet(flash_opt) && !load_flash(parser.value(flash_opt)))
+        return EXIT_FILE;
+
+    do_update = parser.isSet(update_opt);
+    if(do_update && !load_flash(parser.value(update_opt)))
+        return EXIT_FILE;
+
+    if(parser.isSet(verify_opt) && SparseImage::is_sparse_file(parser.value(verify_opt)))
+    {
+        fprintf(stderr, "--verify takes a binary file, --flash and --update verify HEX/S-record/ELF files themselves\n");
+        return EXIT_USAGE;
+    }
+
+    if(parser.isSet(verify_opt) && !load_file(parser.value(verify_opt), &verify_image))
+        return EXIT_FILE;
+
+    return -1;
+}
+
+/**
+* @brief  读取要烧写的固件. 带地址的固件在此检查格式, 连接设备后再由引擎换算地址
+* @param  [in] path QString. 固件文件路径
+* @return 是否成功
+*/
+bool FlashCli::load_flash(const QString &path)
+{
+    if(!SparseImage::is_sparse_file(path))
+        return load_file(path, &flash_image);
+
+    SparseImage sparse;
+    if(!sparse.load(path))
+    {
+        fprintf(stderr, "%s: %s\n", qPrintable(path), qPrintable(sparse.error_string()));
+        return false;
+    }
+
+    sparse_path = path;
+    return true;
+}
+
+bool FlashCli::load_file(const QString &path, FirmwareImage *image)
+{
+    if(!image->open(path))
+    {
+        fprintf(stderr, "%s: %s\n", qPrintable(path), qPrintable(image->error_string()));
+        return false;
+    }
+
+    return true;
+}
+
+void FlashCli::start(void)
+{
+    engine->open_device(port_name, baudrate);
+}
+
+/**
+ * @brief 按 连接 -> 擦除 -> 烧写 -> 校验 -> 引导 的顺序执行下一项操作
+ * @param [in] op int. 刚完成的操作
+ */
+void FlashCli::next(int op)
+{
+    last_percent = -1;
+
+    /* 烧写操作本身包含擦除 */
+    if((op < FlashEngine::OP_ERASE) && do_erase && flash_image.isEmpty() && sparse_path.isEmpty())
+    {
+        engine->erase();
+        return;
+    }
+
+    if((op < FlashEngine::OP_PROGRAM) && !sparse_path.isEmpty())
+    {
+        if(do_update)
+            engine->update_file(sparse_path);
+        else
+            engine->program_file(sparse_path);
+        return;
+    }
+
+    if((op < FlashEngine::OP_PROGRAM) && !flash_image.isEmpty())
+    {
+        if(do_update)
+            engine->update(flash_image.bytes());
+        else
+            engine->program(flash_image.bytes());
+        return;
+    }
+
+    if((op < FlashEngine::OP_VERIFY) && !verify_image.isEmpty())
+    {
+        engine->verify(verify_image.bytes());
+        return;
+    }
+
+    if((op < FlashEngine::OP_BOOT) && do_boot)
+    {
+        engine->boot();
+        return;
+    }
+
+    quit(EXIT_OK);
+}
+
+void FlashCli::quit(int code)
+{
+    if(!trace_path.isEmpty())
+        engine->save_trace(trace_path);
+
+    engine->close_device();
+    QCoreApplication::exit(code);
+}
+
+void FlashCli::engine_device_ready(DeviceInfo info)
+{
+    if(!show_info)
+        return;
+
+    printf("UDID:     %s\n", info.udid.toHex().toUpper().constData());
+    printf("FW size:  %u\n", info.fw_size);
+    printf("BL rev:   %s\n", info.bl_rev.constData());
+    printf("ID:       %s\n", qPrintable(QString::fromLocal8Bit(info.id)));
+    printf("SN:       %s\n", info.sn.constData());
+    printf("Rev:      %s\n", info.rev.constData());
+    printf("Des:      %s\n", info.des.constData());
+    printf("Flash:    %s\n", info.flash_strc.constData());
+    printf("Sectors:  %d\n", info.layout.size());
+    printf("Caps:     0x%08X, LZ block %u\n", info.caps, info.lz_block);
+    printf("Frame:    %u\n", info.frame_max);
+    fflush(stdout);
+}
+
+void FlashCli::engine_progress(int value, int max)
+{
+    if(max <= 0)
+        return;
+
+    int percent = (int)((qint64)value * 100 / max);
+    if(percent == last_percent)
+        return;
+
+    last_percent = percent;
+    fprintf(stderr, "\r%3d%%", percent);
+    if(percent == 100)
+        fprintf(stderr, "\n");
+}
+
+void FlashCli::engine_warning(QString msg)
+{
+    fprintf(stderr, "warning: %s\n", qPrintable(msg));
+}
+
+void FlashCli::engine_finished(int op, bool ok, QString msg)
+{
+    if(ok)
+    {
+        next(op);
+        return;
+    }
+
+    fprintf(stderr, "\nerror: %s\n", qPrintable(msg));
+
+    switch(op)
+    {
+    case FlashEngine::OP_CONNECT:
+        quit(EXIT_CONNECT);
+        break;
+    case FlashEngine::OP_ERASE:
+        quit(EXIT_ERASE);
+        break;
+    case FlashEngine::OP_PROGRAM:
+    case FlashEngine::OP_UPDATE:
+        quit(EXIT_PROGRAM);
+        break;
+    case FlashEngine::OP_VERIFY:
+        quit(EXIT_VERIFY);
+        break;
+    case FlashEngine::OP_BOOT:
+        quit(EXIT_BOOT);
+        break;
+    default:
+        quit(EXIT_USAGE);
+        break;
+    }
+}
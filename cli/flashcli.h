@@ -0,0 +1,63 @@
+#ifndef FLASHCLI_H
+#define FLASHCLI_H
+
+#include <QObject>
+#include <QStringList>
+#include "flashengine.h"
+
+/**
+ * @brief 命令行程序退出码
+ */
+#define EXIT_OK                     0               /*!< 全部操作成功 */
+#define EXIT_USAGE                  1               /*!< 参数错误 */
+#define EXIT_FILE                   2               /*!< 固件文件无法读取 */
+#define EXIT_CONNECT                3               /*!< 连接设备失败 */
+#define EXIT_ERASE                  4               /*!< 擦除失败 */
+#define EXIT_PROGRAM                5               /*!< 烧写或校验失败 */
+#define EXIT_VERIFY                 6               /*!< 校验不一致 */
+#define EXIT_BOOT                   7               /*!< 引导失败 */
+
+/**
+ * @brief 命令行烧写流程: 连接 -> [擦除] -> [烧写] -> [校验] -> [引导]
+ * @note  与界面共用 FlashEngine, 运行于主线程事件循环中, 结束时以退出码退出
+ */
+class FlashCli : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FlashCli(QObject *parent = 0);
+
+    int parse(const QStringList &arguments);
+
+public slots:
+    void start(void);
+
+private slots:
+    void engine_device_ready(DeviceInfo info);
+    void engine_progress(int value, int max);
+    void engine_warning(QString msg);
+    void engine_finished(int op, bool ok, QString msg);
+
+private:
+    FlashEngine *engine;
+
+    QString port_name;
+    int baudrate;
+    bool show_info;
+    bool do_erase;
+    bool do_boot;
+    bool do_update;                         /*!< 以增量方式烧写 flash_image */
+    FirmwareImage flash_image;
+    QString sparse_path;                    /*!< 带地址的固件文件, 由引擎在连接后按固件区地址解析 */
+    FirmwareImage verify_image;
+    QString trace_path;                     /*!< 退出时保存跟踪记录的文件 */
+    int last_percent;
+
+    void next(int op);
+    void quit(int code);
+    bool load_flash(const QString &path);
+    static bool load_file(const QString &path, FirmwareImage *image);
+};
+
+#endif // FLASHCLI_H
@@ -0,0 +1,17 @@
+#include "flashcli.h"
+#include <QCoreApplication>
+#include <QTimer>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    FlashCli cli;
+
+    int code = cli.parse(a.arguments());
+    if(code >= 0)
+        return code;
+
+    QTimer::singleShot(0, &cli, SLOT(start()));
+
+    return a.exec();
+}
@@ -0,0 +1,159 @@
+#include "baudcache.h"
+#include "udidstore.h"
+#include <QSettings>
+#include <QStringList>
+#include <QMutex>
+
+/* 记录格式: 波特率,连续失败次数,最近使用序号 */
+#define CACHE_BAUD                  0
+#define CACHE_FAIL                  1
+#define CACHE_SEQ                   2
+#define CACHE_FIELDS                2               /*!< 设备记录中不含序号的字段数量 */
+
+static QMutex cache_mutex;
+
+/**
+ * @brief 串口名可能含有路径分隔符, 不能直接作为 QSettings 的键
+ */
+static QString port_key(const QString &port_name)
+{
+    QString name = port_name;
+
+    name.replace('/', '_');
+    name.replace('\\', '_');
+    return "/BaudCache/port_" + name;
+}
+
+/**
+ * @brief 读取一条串口记录
+ * @return 是否存在
+ */
+static bool read_entry(QSettings *ini, const QString &key, int *entry)
+{
+    QStringList list = ini->value(key).toString().split(',');
+
+    if(list.count() != 3)
+        return false;
+
+    entry[CACHE_BAUD] = list.at(0).toInt();
+    entry[CACHE_FAIL] = list.at(1).toInt();
+    entry[CACHE_SEQ] = list.at(2).toInt();
+
+    return entry[CACHE_BAUD] > 0;
+}
+
+static void append_unique(QVector<int> *list, int baudrate)
+{
+    if((baudrate > 0) && !list->contains(baudrate))
+        list->append(baudrate);
+}
+
+/**
+* @brief  生成自动探测的波特率顺序
+* @note   依次为: 该串口上次成功的波特率, 已知设备最近使用过的波特率 (新的在前), 其余波特率按原顺序
+* @param  [in] port_name QString. 串口名
+* @param  [in] list const int*. 支持的波特率
+* @param  [in] num int. 支持的波特率数量
+* @return 尝试顺序
+*/
+QVector<int> BaudCache::candidates(const QString &port_name, const int *list, int num)
+{
+    QMutexLocker locker(&cache_mutex);
+    QSettings ini(UdidStore::file(), QSettings::IniFormat);
+    UdidStore store(&ini, "BaudCache", CACHE_FIELDS, BAUD_CACHE_UDID_MAX);
+    QVector<int> result;
+    int entry[3];
+
+    if(read_entry(&ini, port_key(port_name), entry))
+        append_unique(&result, entry[CACHE_BAUD]);
+
+    /* 已知设备按最近使用排序 */
+    QList<QByteArray> devices = store.udids();
+    for(int i = 0; i < devices.size(); i++)
+    {
+        QStringList fields;
+
+        if(store.read(devices.at(i), &fields))
+            append_unique(&result, fields.at(CACHE_BAUD).toInt());
+    }
+
+    for(int i = 0; i < num; i++)
+        append_unique(&result, list[i]);
+
+    return result;
+}
+
+/**
+ * @brief 串口连接成功, 记录波特率并清除失败计数
+ */
+void BaudCache::port_ok(const QString &port_name, int baudrate)
+{
+    QMutexLocker locker(&cache_mutex);
+    QSettings ini(UdidStore::file(), QSettings::IniFormat);
+    UdidStore store(&ini, "BaudCache", CACHE_FIELDS, BAUD_CACHE_UDID_MAX);
+
+    ini.setValue(port_key(port_name), QString("%1,%2,%3").arg(baudrate).arg(0).arg(store.next_seq()));
+}
+
+/**
+ * @brief 串口自动探测失败, 失败次数过多的记录将被删除
+ */
+void BaudCache::port_failed(const QString &port_name)
+{
+    QMutexLocker locker(&cache_mutex);
+    QSettings ini(UdidStore::file(), QSettings::IniFormat);
+    QString key = port_key(port_name);
+    int entry[3];
+
+    if(!read_entry(&ini, key, entry))
+        return;
+
+    if(entry[CACHE_FAIL] + 1 >= BAUD_CACHE_MAX_FAIL)
+        ini.remove(key);
+    else
+        ini.setValue(key, QString("%1,%2,%3").arg(entry[CACHE_BAUD]).arg(entry[CACHE_FAIL] + 1).arg(entry[CACHE_SEQ]));
+}
+
+/**
+ * @brief 记录设备使用的波特率, 设备记录超过 BAUD_CACHE_UDID_MAX 条时删除最久未使用的
+ */
+void BaudCache::udid_ok(const QByteArray &udid, int baudrate)
+{
+    QMutexLocker locker(&cache_mutex);
+    QSettings ini(UdidStore::file(), QSettings::IniFormat);
+    UdidStore store(&ini, "BaudCache", CACHE_FIELDS, BAUD_CACHE_UDID_MAX);
+
+    store.write(udid, QStringList() << QString::number(baudrate) << "0");
+}
+
+/**
+* @brief  自动探测在其他波特率下找到设备, 之前尝试的波特率均无应答
+* @note   使用这些波特率的设备记录累计失败次数 (不更新最近使用序号), 达到 BAUD_CACHE_MAX_FAIL 时删除,
+*         以免失效的记录一直占用位置. 设备再次连接成功时失败次数清零
+* @param  [in] bauds QVector<int>. 无应答的波特率
+*/
+void BaudCache::bauds_failed(const QVector<int> &bauds)
+{
+    QMutexLocker locker(&cache_mutex);
+    QSettings ini(UdidStore::file(), QSettings::IniFormat);
+    UdidStore store(&ini, "BaudCache", CACHE_FIELDS, BAUD_CACHE_UDID_MAX);
+    QList<QByteArray> devices = store.udids();
+
+    for(int i = 0; i < devices.size(); i++)
+    {
+        QStringList fields;
+
+        if(!store.read(devices.at(i), &fields) || !bauds.contains(fields.at(CACHE_BAUD).toInt()))
+            continue;
+
+        int fail = fields.at(CACHE_FAIL).toInt() + 1;
+        if(fail >= BAUD_CACHE_MAX_FAIL)
+        {
+            store.remove(devices.at(i));
+            continue;
+        }
+
+        fields[CACHE_FAIL] = QString::number(fail);
+        store.write(devices.at(i), fields, false);
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef BAUDCACHE_H
+#define BAUDCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+
+#define BAUD_CACHE_MAX_FAIL         3               /*!< 记录的波特率连续探测失败次数达到该值后删除 */
+#define BAUD_CACHE_UDID_MAX         16              /*!< 保留的设备记录数量, 超出时删除最久未使用的 */
+
+/**
+ * @brief 波特率缓存
+ * @note  按串口名与设备 UDID 记录上次连接成功的波特率, 保存在程序目录的 config.ini 中 [BaudCache] 组下.
+ *        自动探测时先尝试缓存中的波特率. 所有函数均可在多个烧写线程中同时调用
+ */
+class BaudCache
+{
+public:
+    static QVector<int> candidates(const QString &port_name, const int *list, int num);
+    static void port_ok(const QString &port_name, int baudrate);
+    static void port_failed(const QString &port_name);
+    static void udid_ok(const QByteArray &udid, int baudrate);
+    static void bauds_failed(const QVector<int> &bauds);
+};
+
+#endif // BAUDCACHE_H
@@ -0,0 +1,372 @@
+#include "bootloadersim.h"
+#include "protocol.h"
+#include "crc32.h"
+#include "lzblock.h"
+#include <string.h>
+
+BootloaderSim::BootloaderSim()
+{
+    state = S_CMD;
+    cur_cmd = 0;
+    arg_len = 0;
+    arg_count = 0;
+    prog_ptr = 0;
+    boot_flag = false;
+    baud = SIM_BAUD_DEFAULT;
+    prev_baud = SIM_BAUD_DEFAULT;
+    max_baud = SIM_BAUD_MAX;
+    baud_pending = false;
+    caps = PROTO_CAP_LZ;
+    lz_block = SIM_LZ_BLOCK;
+    frame_max = SIM_FRAME_MAX;
+
+    QByteArray udid;
+    for(int i = 0; i < 12; i++)
+        udid.append((char)(0x30 + i));
+
+    info.insert(PROTO_GET_UDID, udid);
+    info.insert(PROTO_GET_BL_REV, BL_PROTOCOL_VERSION);
+    info.insert(PROTO_GET_ID, "OrangeBoot Sim");
+    info.insert(PROTO_GET_SN, "00000001");
+    info.insert(PROTO_GET_REV, "1.0");
+    info.insert(PROTO_GET_DES, "OrangeBoot bootloader simulator");
+
+    flash_strc = SIM_FLASH_STRC;
+    layout.parse(flash_strc);
+    set_fw_size(SIM_FW_SIZE);
+}
+
+/**
+ * @brief 设置固件区大小, 固件区内容恢复为擦除状态
+ */
+void BootloaderSim::set_fw_size(uint size)
+{
+    fw.fill((char)0xff, size);
+    prog_ptr = 0;
+    sectors = layout.fw_area(size);
+}
+
+void BootloaderSim::set_flash_strc(const QByteArray &text)
+{
+    flash_strc = text;
+    layout.parse(flash_strc);
+    sectors = layout.fw_area(fw.size());
+}
+
+/**
+ * @brief 设置查询指令返回的设备信息
+ */
+void BootloaderSim::set_info(int cmd, const QByteArray &data)
+{
+    info.insert(cmd, data);
+}
+
+bool BootloaderSim::has_args(int cmd)
+{
+    switch(cmd)
+    {
+    case PROTO_SET_BAUD:
+    case PROTO_PROG_MULTI:
+    case PROTO_SECTOR_ERASE:
+    case PROTO_GET_RANGE_CRC:
+    case PROTO_SET_PROG_ADDR:
+    case PROTO_PROG_SKIP:
+    case PROTO_PROG_LZ:
+    case PROTO_PROG_MULTI_EXT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+* @brief  接收一个字节
+* @param  [in] c unsigned char. 主机发来的字节
+* @param  [out] reply QByteArray*. 应答数据
+* @param  [out] cmd int*. 完成的指令
+* @return 是否完成一条指令
+*/
+bool BootloaderSim::input(unsigned char c, QByteArray *reply, int *cmd)
+{
+    switch(state)
+    {
+    case S_CMD:
+        cur_cmd = c;
+        arg_count = 0;
+        arg_len = 0;
+        state = has_args(c) ? S_LEN : S_EOC;
+        return false;
+
+    case S_LEN:
+        arg_len = c;
+        if(cur_cmd == PROTO_PROG_MULTI_EXT)
+            state = S_LEN_HI;
+        else
+            state = (arg_len > 0) ? S_ARGS : S_EOC;
+        return false;
+
+    case S_LEN_HI:
+        arg_len |= c << 8;
+        state = (arg_len > 0) ? S_ARGS : S_EOC;
+        return false;
+
+    case S_ARGS:
+        args[arg_count++] = c;
+        if(arg_count == arg_len)
+            state = S_EOC;
+        return false;
+
+    default:
+        break;
+    }
+
+    state = S_CMD;
+    *cmd = cur_cmd;
+    reply->clear();
+
+    if(c != PROTO_EOC)
+    {
+        reply->append((char)PROTO_INSYNC);
+        reply->append((char)PROTO_INVALID);
+        return true;
+    }
+
+    /* 在新波特率下收到有效指令, 切换完成 */
+    if(cur_cmd != PROTO_SET_BAUD)
+        baud_pending = false;
+
+    execute(reply);
+    return true;
+}
+
+/**
+ * @brief 切换波特率后未收到有效指令, 恢复原波特率
+ */
+void BootloaderSim::revert_baud(void)
+{
+    if(!baud_pending)
+        return;
+
+    baud = prev_baud;
+    baud_pending = false;
+}
+
+uint BootloaderSim::arg_u32(int pos) const
+{
+    return (uint)args[pos] | ((uint)args[pos + 1] << 8) | ((uint)args[pos + 2] << 16) | ((uint)args[pos + 3] << 24);
+}
+
+void BootloaderSim::append_u32(QByteArray *data, uint value)
+{
+    data->append((char)(value & 0xff));
+    data->append((char)((value >> 8) & 0xff));
+    data->append((char)((value >> 16) & 0xff));
+    data->append((char)((value >> 24) & 0xff));
+}
+
+/**
+ * @brief 执行一条完整的指令并生成应答
+ */
+void BootloaderSim::execute(QByteArray *reply)
+{
+    uint fw_size = fw.size();
+    int status = PROTO_OK;
+
+    switch(cur_cmd)
+    {
+    case PROTO_GET_SYNC:
+        break;
+
+    case PROTO_SET_BAUD:
+    {
+        int rate = (int)arg_u32(0);
+
+        if((arg_len != 4) || (rate <= 0) || (rate > max_baud))
+        {
+            status = PROTO_FAILED;
+            break;
+        }
+
+        prev_baud = baud;
+        baud = rate;
+        baud_pending = true;
+        break;
+    }
+
+    case PROTO_GET_UDID:
+    case PROTO_GET_BL_REV:
+    case PROTO_GET_ID:
+    case PROTO_GET_SN:
+    case PROTO_GET_REV:
+    case PROTO_GET_DES:
+        reply->append(info.value(cur_cmd));
+        break;
+
+    case PROTO_GET_FW_SIZE:
+        append_u32(reply, fw_size);
+        break;
+
+    case PROTO_GET_FLASH_STRC:
+        reply->append(flash_strc);
+        break;
+
+    case PROTO_GET_CAPS:
+        /* 模拟旧版 bootloader 时不支持 */
+        if(caps == 0)
+        {
+            status = PROTO_INVALID;
+            break;
+        }
+
+        append_u32(reply, caps);
+        append_u32(reply, lz_block);
+        break;
+
+    case PROTO_GET_FRAME_MAX:
+        if(frame_max == 0)
+        {
+            status = PROTO_INVALID;
+            break;
+        }
+
+        append_u32(reply, frame_max);
+        break;
+
+    case PROTO_CHIP_ERASE:
+        fw.fill((char)0xff);
+        prog_ptr = 0;
+        break;
+
+    case PROTO_PROG_MULTI:
+    case PROTO_PROG_MULTI_EXT:
+        /* 长帧只在声明支持时有效; 声明的长度小于一字节能表示的长度时普通帧也受其限制 */
+        if((cur_cmd == PROTO_PROG_MULTI_EXT) && (frame_max <= 255))
+        {
+            status = PROTO_INVALID;
+            break;
+        }
+
+        if(((frame_max > 0) && ((uint)arg_len > frame_max)) || (prog_ptr + arg_len > fw_size))
+        {
+            status = PROTO_FAILED;
+            break;
+        }
+
+        /* FLASH 编程只能将 1 写为 0 */
+        for(int i = 0; i < arg_len; i++)
+            fw[prog_ptr + i] = fw.at(prog_ptr + i) & args[i];
+        prog_ptr += arg_len;
+        break;
+
+    case PROTO_GET_CRC:
+        append_u32(reply, crc32(fw.constData(), fw_size, 0));
+        break;
+
+    case PROTO_BOOT:
+        boot_flag = true;
+        break;
+
+    case PROTO_SECTOR_ERASE:
+    {
+        uint offset = arg_u32(0);
+        uint len = arg_u32(4);
+
+        if((arg_len != 8) || sectors.isEmpty() || (offset > fw_size) || (len > fw_size - offset))
+        {
+            status = PROTO_FAILED;
+            break;
+        }
+
+        for(int i = 0; i < sectors.size(); i++)
+        {
+            const FlashSector &s = sectors.at(i);
+            if((s.address < offset + len) && (s.address + s.size > offset))
+                memset(fw.data() + s.address, 0xff, s.size);
+        }
+        break;
+    }
+
+    case PROTO_GET_RANGE_CRC:
+    {
+        uint offset = arg_u32(0);
+        uint len = arg_u32(4);
+
+        if((arg_len != 8) || (offset > fw_size) || (len > fw_size - offset))
+        {
+            status = PROTO_FAILED;
+            break;
+        }
+
+        append_u32(reply, crc32(fw.constData() + offset, len, 0));
+        break;
+    }
+
+    case PROTO_SET_PROG_ADDR:
+    {
+        uint offset = arg_u32(0);
+
+        if((arg_len != 4) || (offset > fw_size))
+        {
+            status = PROTO_FAILED;
+            break;
+        }
+
+        prog_ptr = offset;
+        break;
+    }
+
+    case PROTO_GET_PROG_ADDR:
+        append_u32(reply, prog_ptr);
+        break;
+
+    case PROTO_PROG_SKIP:
+    {
+        uint len = arg_u32(0);
+
+        if((arg_len != 4) || (len % 4 != 0) || (len > fw_size - prog_ptr))
+        {
+            status = PROTO_FAILED;
+            break;
+        }
+
+        prog_ptr += len;
+        break;
+    }
+
+    case PROTO_PROG_LZ:
+    {
+        if(!(caps & PROTO_CAP_LZ))
+        {
+            status = PROTO_INVALID;
+            break;
+        }
+
+        /* 解压到缓冲区, 长度与声明的原始长度一致才写入 */
+        uint raw_len = (arg_len >= 2) ? (args[0] | (args[1] << 8)) : 0;
+        QByteArray block(raw_len, 0);
+
+        if((arg_len < 2) || (raw_len == 0) || (raw_len > lz_block) || (raw_len > fw_size - prog_ptr) ||
+           (lz_decompress((const char *)args + 2, arg_len - 2, block.data(), raw_len) != (int)raw_len))
+        {
+            status = PROTO_FAILED;
+            break;
+        }
+
+        for(uint i = 0; i < raw_len; i++)
+            fw[prog_ptr + i] = fw.at(prog_ptr + i) & block.at(i);
+        prog_ptr += raw_len;
+        break;
+    }
+
+    default:
+        status = PROTO_INVALID;
+        break;
+    }
+
+    /* 失败时不返回数据 */
+    if(status != PROTO_OK)
+        reply->clear();
+
+    reply->append((char)PROTO_INSYNC);
+    reply->append((char)status);
+}
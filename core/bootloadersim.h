@@ -0,0 +1,84 @@
+#ifndef BOOTLOADERSIM_H
+#define BOOTLOADERSIM_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "flashlayout.h"
+
+#define SIM_FLASH_STRC              "@Internal Flash/0x08000000/04*016Kg,01*064Kg,07*128Kg"
+#define SIM_FW_SIZE                 (1008 * 1024)   /*!< 第一个 16K 扇区为 bootloader, 其余为固件区 */
+#define SIM_BAUD_DEFAULT            115200          /*!< 复位后的波特率 */
+#define SIM_BAUD_MAX                2000000         /*!< 支持的最高波特率 */
+#define SIM_LZ_BLOCK                4096            /*!< 解压缓冲区大小 */
+#define SIM_FRAME_MAX               4096            /*!< 烧写指令的最大数据长度 */
+#define SIM_ARGS_MAX                65536           /*!< 参数缓存大小, 可容纳 2 字节长度能表示的全部参数 */
+
+/**
+ * @brief Bootloader 协议模拟
+ * @note  逐字节接收主机数据, 每完成一条指令即生成应答. 只模拟协议与 FLASH 内容, 不含时序,
+ *        波特率, 延时等由调用者负责: PROTO_SET_BAUD 的应答发送完后按 baudrate() 切换,
+ *        baud_unconfirmed() 持续 PROTO_BAUD_REVERT_TIME 后调用 revert_baud()
+ */
+class BootloaderSim
+{
+public:
+    BootloaderSim();
+
+    void set_fw_size(uint size);
+    void set_flash_strc(const QByteArray &text);
+    void set_info(int cmd, const QByteArray &data);
+    void set_max_baudrate(int baudrate) { max_baud = baudrate; }
+    void set_caps(uint caps, uint lz_block) { this->caps = caps; this->lz_block = lz_block; }
+    void set_frame_max(uint bytes) { frame_max = bytes; }
+
+    void revert_baud(void);
+
+    bool input(unsigned char c, QByteArray *reply, int *cmd);
+
+    const QByteArray &flash(void) const { return fw; }
+    uint prog_addr(void) const { return prog_ptr; }
+    bool booted(void) const { return boot_flag; }
+    int baudrate(void) const { return baud; }
+    bool baud_unconfirmed(void) const { return baud_pending; }
+
+private:
+    enum
+    {
+        S_CMD = 0,          /*!< 等待指令 */
+        S_LEN,              /*!< 等待参数长度 */
+        S_LEN_HI,           /*!< 等待长帧参数长度的高字节 */
+        S_ARGS,             /*!< 接收参数 */
+        S_EOC               /*!< 等待 EOC */
+    };
+
+    int state;
+    int cur_cmd;
+    int arg_len;
+    int arg_count;
+    unsigned char args[SIM_ARGS_MAX];
+
+    QByteArray fw;                          /*!< 固件区内容 */
+    uint prog_ptr;                          /*!< 编程指针, 相对固件区起始位置 */
+    bool boot_flag;
+    QByteArray flash_strc;
+    FlashLayout layout;                     /*!< 全部扇区 */
+    FlashLayout sectors;                    /*!< 固件区扇区 */
+    QHash<int, QByteArray> info;
+
+    int baud;                               /*!< 当前波特率, SET_BAUD 的应答发送完后生效 */
+    int prev_baud;
+    int max_baud;
+    bool baud_pending;                      /*!< 已切换波特率, 尚未在新波特率下收到有效指令 */
+    uint caps;                              /*!< PROTO_GET_CAPS 返回的功能, 为 0 时不支持该指令 */
+    uint lz_block;
+    uint frame_max;                         /*!< PROTO_GET_FRAME_MAX 返回的长度, 为 0 时不支持该指令与长帧 */
+
+    void execute(QByteArray *reply);
+    uint arg_u32(int pos) const;
+    static bool has_args(int cmd);
+    static void append_u32(QByteArray *data, uint value);
+};
+
+#endif // BOOTLOADERSIM_H
@@ -0,0 +1,58 @@
+#-------------------------------------------------
+#
+# 协议与烧写引擎, 供界面与命令行工具共用
+#
+#-------------------------------------------------
+
+QT       += core
+QT       += serialport
+QT       -= gui
+
+TARGET = obcore
+TEMPLATE = lib
+CONFIG += staticlib
+
+# crc32.cpp 的查找表在编译期生成, 需要 C++14 的 constexpr
+CONFIG += c++14
+
+# The following define makes your compiler emit warnings if you use
+# any feature of Qt which has been marked as deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    baudcache.cpp \
+    bootloadersim.cpp \
+    crc32.cpp \
+    firmwareimage.cpp \
+    flashengine.cpp \
+    flashlayout.cpp \
+    framepacker.cpp \
+    linktimer.cpp \
+    lzblock.cpp \
+    multiflasher.cpp \
+    progresume.cpp \
+    replyparser.cpp \
+    sparseimage.cpp \
+    tracebuffer.cpp \
+    udidstore.cpp
+
+HEADERS += \
+    baudcache.h \
+    bootloadersim.h \
+    crc32.h \
+    firmwareimage.h \
+    protocol.h \
+    flashengine.h \
+    flashlayout.h \
+    frameencoder.h \
+    framepacker.h \
+    linktimer.h \
+    lzblock.h \
+    multiflasher.h \
+    progresume.h \
+    replyparser.h \
+    sparseimage.h \
+    tracebuffer.h \
+    udidstore.h
@@ -0,0 +1,349 @@
+#include "crc32.h"
+#include <stdio.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CRC32_HAVE_PCLMUL           1
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CRC32_TARGET_PCLMUL
+#else
+#include <cpuid.h>
+#define CRC32_TARGET_PCLMUL         __attribute__((target("pclmul,sse4.1")))
+#endif
+#else
+#define CRC32_HAVE_PCLMUL           0
+#endif
+
+#define CRC32_POLY                  0xedb88320U     /*!< 反射多项式 */
+#define CRC32_SLICES                16              /*!< 每次处理的字节数 */
+#define CRC32_PCLMUL_MIN            64              /*!< 使用 PCLMUL 折叠的最短数据长度 */
+
+/**
+ * @brief 查表法所需的 16 张表, 编译期生成
+ * @note  table[0] 为逐字节查表, table[k][i] 为字节 i 之后再经过 k 个零字节的结果
+ */
+struct Crc32Table
+{
+	uint table[CRC32_SLICES][256];
+};
+
+static constexpr Crc32Table crc32_make_table(void)
+{
+	Crc32Table t = {};
+
+	for (unsigned int i = 0; i < 256; i++)
+	{
+		uint c = i;
+
+		for (unsigned int j = 0; j < 8; j++)
+		{
+			if (c & 1)
+			{
+				c = CRC32_POLY ^ (c >> 1);
+			}
+			else
+			{
+				c = c >> 1;
+			}
+		}
+
+		t.table[0][i] = c;
+	}
+
+	for (unsigned int k = 1; k < CRC32_SLICES; k++)
+	{
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			uint c = t.table[k - 1][i];
+			t.table[k][i] = (c >> 8) ^ t.table[0][c & 0xff];
+		}
+	}
+
+	return t;
+}
+
+static constexpr Crc32Table crctab = crc32_make_table();
+
+static inline uint load_le32(const unsigned char *p)
+{
+	return (uint)p[0] | ((uint)p[1] << 8) | ((uint)p[2] << 16) | ((uint)p[3] << 24);
+}
+
+/**
+ * @brief 通用实现, 每次处理 16 字节 (slicing-by-16)
+ */
+static uint crc32_slice(const unsigned char *p, size_t len, uint state)
+{
+	const uint (*t)[256] = crctab.table;
+
+	while (len >= CRC32_SLICES)
+	{
+		uint a = state ^ load_le32(p);
+		uint b = load_le32(p + 4);
+		uint c = load_le32(p + 8);
+		uint d = load_le32(p + 12);
+
+		state = t[15][a & 0xff] ^ t[14][(a >> 8) & 0xff] ^ t[13][(a >> 16) & 0xff] ^ t[12][a >> 24]
+		      ^ t[11][b & 0xff] ^ t[10][(b >> 8) & 0xff] ^ t[9][(b >> 16) & 0xff]  ^ t[8][b >> 24]
+		      ^ t[7][c & 0xff]  ^ t[6][(c >> 8) & 0xff]  ^ t[5][(c >> 16) & 0xff]  ^ t[4][c >> 24]
+		      ^ t[3][d & 0xff]  ^ t[2][(d >> 8) & 0xff]  ^ t[1][(d >> 16) & 0xff]  ^ t[0][d >> 24];
+
+		p += CRC32_SLICES;
+		len -= CRC32_SLICES;
+	}
+
+	while (len--)
+	{
+		state = t[0][(state ^ *p++) & 0xff] ^ (state >> 8);
+	}
+
+	return state;
+}
+
+#if CRC32_HAVE_PCLMUL
+/**
+ * @brief 使用 PCLMULQDQ 折叠计算, len 须不小于 64 且为 16 的倍数
+ * @note  常数取自 Intel "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+ *        中反射域下的 k1~k5 与 Barrett 约简参数
+ */
+CRC32_TARGET_PCLMUL
+static uint crc32_pclmul(const unsigned char *p, size_t len, uint state)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596LL, 0x0154442bd4LL);
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009eLL, 0x01751997d0LL);
+	const __m128i k5k0 = _mm_set_epi64x(0x0000000000LL, 0x0163cd6124LL);
+	const __m128i poly = _mm_set_epi64x(0x01f7011641LL, 0x01db710641LL);
+	const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+
+	__m128i x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x1 = _mm_loadu_si128((const __m128i *)(p + 0x00));
+	x2 = _mm_loadu_si128((const __m128i *)(p + 0x10));
+	x3 = _mm_loadu_si128((const __m128i *)(p + 0x20));
+	x4 = _mm_loadu_si128((const __m128i *)(p + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)state));
+
+	p += 64;
+	len -= 64;
+
+	/* 4 路并行折叠, 每次 64 字节 */
+	while (len >= 64)
+	{
+		x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(p + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(p + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(p + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(p + 0x30)));
+
+		p += 64;
+		len -= 64;
+	}
+
+	/* 合并为 128 位 */
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	/* 剩余的 16 字节块 */
+	while (len >= 16)
+	{
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)p)), x5);
+
+		p += 16;
+		len -= 16;
+	}
+
+	/* 128 位折叠到 64 位 */
+	x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+	x1 = _mm_srli_si128(x1, 8);
+	x1 = _mm_xor_si128(x1, x2);
+
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask);
+	x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/* Barrett 约简到 32 位 */
+	x2 = _mm_and_si128(x1, mask);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+	x2 = _mm_and_si128(x2, mask);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return (uint)_mm_extract_epi32(x1, 1);
+}
+
+static bool cpu_has_pclmul(void)
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return ((info[2] & (1 << 1)) != 0) && ((info[2] & (1 << 19)) != 0);
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return false;
+	return ((ecx & bit_PCLMUL) != 0) && ((ecx & bit_SSE4_1) != 0);
+#endif
+}
+#endif
+
+bool crc32_accelerated(void)
+{
+#if CRC32_HAVE_PCLMUL
+	/* 静态局部变量的初始化是线程安全的, CPU 特性只检测一次 */
+	static const bool use_pclmul = cpu_has_pclmul();
+
+	return use_pclmul;
+#else
+	return false;
+#endif
+}
+
+uint crc32(const void *data, size_t len, uint state)
+{
+	const unsigned char *p = (const unsigned char *)data;
+
+#if CRC32_HAVE_PCLMUL
+	if (crc32_accelerated() && (len >= CRC32_PCLMUL_MIN))
+	{
+		size_t n = len & ~(size_t)15;
+
+		state = crc32_pclmul(p, n, state);
+		p += n;
+		len -= n;
+	}
+#endif
+
+	return crc32_slice(p, len, state);
+}
+
+uint crc32_generic(const void *data, size_t len, uint state)
+{
+	return crc32_slice((const unsigned char *)data, len, state);
+}
+
+uint crc32(QByteArray *src, uint len, uint state)
+{
+	return crc32(src->constData(), len, state);
+}
+
+/*
+ * 追加一个字节 b 的运算为 s' = Z(s) ^ table[b], 其中 Z 为追加一个零字节的 GF(2) 线性变换.
+ * 追加 n 个相同字节即为该仿射变换的 n 次幂, 用 32x32 的 GF(2) 矩阵按二进制拆分 n 求幂.
+ * 矩阵按列存放, mat[j] 为输入第 j 位为 1 时的输出.
+ */
+static uint gf2_matrix_times(const uint *mat, uint vec)
+{
+	uint sum = 0;
+
+	while (vec)
+	{
+		if (vec & 1)
+			sum ^= *mat;
+		vec >>= 1;
+		mat++;
+	}
+
+	return sum;
+}
+
+static void gf2_matrix_square(uint *square, const uint *mat)
+{
+	for (unsigned int n = 0; n < 32; n++)
+	{
+		square[n] = gf2_matrix_times(mat, mat[n]);
+	}
+}
+
+void crc32_fill_prepare(Crc32Fill *fill, unsigned char value, size_t count)
+{
+	uint even[32];
+	uint odd[32];
+	uint prod[32];
+	uint *mat = even;
+	uint *tmp = odd;
+	uint add = crctab.table[0][value];      /* 对 0 状态追加一个 value 字节 */
+
+	/* 结果从恒等变换开始 */
+	for (unsigned int j = 0; j < 32; j++)
+	{
+		fill->mat[j] = 1U << j;
+	}
+	fill->add = 0;
+
+	/* 追加一个零字节的变换矩阵 */
+	for (unsigned int j = 0; j < 32; j++)
+	{
+		uint bit = 1U << j;
+		mat[j] = crctab.table[0][bit & 0xff] ^ (bit >> 8);
+	}
+
+	/* 当前为 2^k 次幂的变换 (mat, add), 对应位为 1 时合并到结果中, 然后平方 */
+	while (count)
+	{
+		if (count & 1)
+		{
+			for (unsigned int j = 0; j < 32; j++)
+			{
+				prod[j] = gf2_matrix_times(mat, fill->mat[j]);
+			}
+			for (unsigned int j = 0; j < 32; j++)
+			{
+				fill->mat[j] = prod[j];
+			}
+			fill->add = gf2_matrix_times(mat, fill->add) ^ add;
+		}
+
+		count >>= 1;
+		if (count == 0)
+			break;
+
+		add = gf2_matrix_times(mat, add) ^ add;
+		gf2_matrix_square(tmp, mat);
+
+		uint *swap = mat;
+		mat = tmp;
+		tmp = swap;
+	}
+}
+
+uint crc32_fill_apply(const Crc32Fill *fill, uint state)
+{
+	return gf2_matrix_times(fill->mat, state) ^ fill->add;
+}
+
+uint crc32_fill(unsigned char value, size_t count, uint state)
+{
+	Crc32Fill fill;
+
+	crc32_fill_prepare(&fill, value, count);
+	return crc32_fill_apply(&fill, state);
+}
+
+uint crc32_combine(uint crc1, uint crc2, size_t len2)
+{
+	return crc32_fill(0, len2, crc1) ^ crc2;
+}
@@ -0,0 +1,50 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <QByteArray>
+#include <stddef.h>
+
+/**
+ * @brief CRC32 (多项式 0xEDB88320, 反射, 无初值取反与结果取反), 与 bootloader 的计算方式一致
+ * @note  state 为上一段数据的计算结果, 首段传入 0
+ */
+uint crc32(const void *data, size_t len, uint state);
+uint crc32(QByteArray *src, uint len, uint state);
+
+/**
+ * @brief 只使用查表法计算, 结果与 crc32 相同, 供测试对比
+ */
+uint crc32_generic(const void *data, size_t len, uint state);
+
+/**
+ * @brief 本机是否使用 PCLMULQDQ 计算 (长度不小于 64 字节时)
+ */
+bool crc32_accelerated(void);
+
+/**
+ * @brief 在 state 之后追加 count 个相同字节 value 的CRC, 计算量为 O(log count)
+ */
+uint crc32_fill(unsigned char value, size_t count, uint state);
+
+/**
+ * @brief 预先计算好的 "追加 count 个相同字节" 变换, 作用于任意 state 只需一次矩阵乘法
+ */
+struct Crc32Fill
+{
+    uint mat[32];
+    uint add;
+};
+
+void crc32_fill_prepare(Crc32Fill *fill, unsigned char value, size_t count);
+uint crc32_fill_apply(const Crc32Fill *fill, uint state);
+
+/**
+ * @brief 合并两段数据的CRC
+ * @param crc1 第一段数据的CRC
+ * @param crc2 第二段数据从 0 开始计算的CRC
+ * @param len2 第二段数据长度
+ * @return 两段数据连接后的CRC
+ */
+uint crc32_combine(uint crc1, uint crc2, size_t len2);
+
+#endif
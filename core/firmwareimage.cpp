@@ -0,0 +1,148 @@
+#include "firmwareimage.h"
+#include <string.h>
+
+FirmwareImage::FirmwareImage()
+{
+    ptr = buf.constData();
+    len = 0;
+    crc_value = 0;
+    crc_valid = false;
+}
+
+/**
+ * @brief 使用已在内存中的数据, 不复制
+ */
+FirmwareImage::FirmwareImage(const QByteArray &data) :
+    buf(data)
+{
+    ptr = buf.constData();
+    len = buf.size();
+    crc_value = 0;
+    crc_valid = false;
+}
+
+/**
+* @brief  打开固件文件
+* @param  [in] path QString. 文件路径
+* @return 是否成功. 失败原因由 error_string 返回
+*/
+bool FirmwareImage::open(const QString &path)
+{
+    QSharedPointer<QFile> f(new QFile(path));
+
+    close();
+
+    if(!f->open(QIODevice::ReadOnly))
+    {
+        error = f->errorString();
+        return false;
+    }
+
+    qint64 size = f->size();
+    uchar *map = (size > 0) ? f->map(0, size) : NULL;
+
+    if(map != NULL)
+    {
+        file = f;
+        ptr = (const char *)map;
+        len = size;
+        return true;
+    }
+
+    /* 不能映射的文件 (管道, 部分网络文件系统等) 读入内存 */
+    buf = f->readAll();
+    f->close();
+
+    if(buf.size() != size)
+    {
+        error = "文件读取失败";
+        buf.clear();
+        ptr = buf.constData();
+        return false;
+    }
+
+    ptr = buf.constData();
+    len = buf.size();
+    return true;
+}
+
+void FirmwareImage::close(void)
+{
+    file.clear();
+    buf.clear();
+    ptr = buf.constData();
+    len = 0;
+    error.clear();
+    crc_value = 0;
+    crc_valid = false;
+}
+
+/**
+* @brief  以 QByteArray 形式访问数据, 不复制
+* @note   映射的数据通过 fromRawData 引用, 只能在本对象 (或其副本) 存在期间使用
+* @return 数据
+*/
+QByteArray FirmwareImage::bytes(void) const
+{
+    if(mapped())
+        return QByteArray::fromRawData(ptr, len);
+
+    return buf;
+}
+
+/**
+* @brief  检查 [pos, pos+count) 是否全为 0xFF (擦除后的值)
+* @note   按 8 字节一组做按位与, 每 32 字节判断一次, 非空白数据通常在第一组即可判定
+* @param  [in] pos qint64. 起始位置
+* @param  [in] count qint64. 长度
+* @return 是否全为 0xFF
+*/
+bool FirmwareImage::blank(qint64 pos, qint64 count) const
+{
+    const char *p = ptr + pos;
+    const quint64 ones = ~(quint64)0;
+    quint64 w[4];
+
+    while(count >= 32)
+    {
+        memcpy(w, p, 32);
+        if((w[0] & w[1] & w[2] & w[3]) != ones)
+            return false;
+        p += 32;
+        count -= 32;
+    }
+
+    while(count >= 8)
+    {
+        memcpy(w, p, 8);
+        if(w[0] != ones)
+            return false;
+        p += 8;
+        count -= 8;
+    }
+
+    while(count > 0)
+    {
+        if((unsigned char)*p != 0xff)
+            return false;
+        p++;
+        count--;
+    }
+
+    return true;
+}
+
+/**
+* @brief  去掉 [base, end) 末尾的 0xFF
+* @return 去掉后的结束位置, 全为 0xFF 时返回 base
+*/
+qint64 FirmwareImage::trim_blank(qint64 base, qint64 end) const
+{
+    while((end - base >= 32) && blank(end - 32, 32))
+        end -= 32;
+
+    while((end > base) && ((unsigned char)ptr[end - 1] == 0xff))
+        end--;
+
+    return end;
+}
@@ -0,0 +1,54 @@
+#ifndef FIRMWAREIMAGE_H
+#define FIRMWAREIMAGE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+#include <QMetaType>
+
+/**
+ * @brief 固件数据
+ * @note  优先将文件映射到内存, 不能映射时读入内存. 副本之间共享同一份数据,
+ *        映射在最后一个副本销毁时解除. 数据只读
+ */
+class FirmwareImage
+{
+public:
+    FirmwareImage();
+    explicit FirmwareImage(const QByteArray &data);
+
+    bool open(const QString &path);
+    void close(void);
+
+    const char *data(void) const { return ptr; }
+    qint64 size(void) const { return len; }
+    bool isEmpty(void) const { return len == 0; }
+    bool mapped(void) const { return !file.isNull(); }
+    QString error_string(void) const { return error; }
+
+    QByteArray bytes(void) const;
+
+    /**
+     * @brief 预先计算的整个数据的CRC (初值 0), 多个会话烧写同一固件时只计算一次, 副本之间一并复制
+     */
+    void set_crc(uint crc) { crc_value = crc; crc_valid = true; }
+    bool crc_known(void) const { return crc_valid; }
+    uint crc(void) const { return crc_value; }
+
+    bool blank(qint64 pos, qint64 count) const;
+    qint64 trim_blank(qint64 base, qint64 end) const;
+
+private:
+    QSharedPointer<QFile> file;             /*!< 映射所属的文件, 映射期间保持打开 */
+    QByteArray buf;                         /*!< 未映射时的数据 */
+    const char *ptr;
+    qint64 len;
+    QString error;
+    uint crc_value;
+    bool crc_valid;
+};
+
+Q_DECLARE_METATYPE(FirmwareImage)
+
+#endif // FIRMWAREIMAGE_H
@@ -0,0 +1,1873 @@
+#include "flashengine.h"
+#include "baudcache.h"
+#include "progresume.h"
+#include "protocol.h"
+#include "crc32.h"
+#include <QCryptographicHash>
+#include <qdebug.h>
+
+#define SerialPortBufferSize        2048            /*!< 串口缓存大小，单位字节 */
+
+#define MAX_ERASE_TIME              1000            /*!< 最长擦除等待时间, 单位 10ms*/
+#define MAX_CRC_TIME                500             /*!< 最长校验等待时间, 单位 10ms*/
+#define PROG_ACK_TIMEOUT            1000            /*!< 烧写应答超时时间, 单位 ms */
+#define TICK_INTERVAL               50              /*!< 擦除/校验进度刷新间隔, 单位 ms */
+#define BAUD_CONFIRM_TRIES          3               /*!< 切换波特率后确认同步的次数 */
+
+/**
+ * @brief 连接设备后读取的设备信息及其超时时间, 单位 ms
+ * @note  所有查询指令一次连续发出, 应答按顺序解析; 超时时间为等待每个应答的上限
+ */
+static const int query_list[][2] =
+{
+    {PROTO_GET_UDID,        20},
+    {PROTO_GET_FW_SIZE,     20},
+    {PROTO_GET_BL_REV,      20},
+    {PROTO_GET_ID,          20},
+    {PROTO_GET_SN,          20},
+    {PROTO_GET_REV,         20},
+    {PROTO_GET_DES,         100},
+    {PROTO_GET_FLASH_STRC,  100},
+    {PROTO_GET_CAPS,        20},
+    {PROTO_GET_FRAME_MAX,   20},
+};
+
+#define QUERY_NUM                   ((int)(sizeof(query_list) / sizeof(query_list[0])))
+
+/**
+ * @brief 读取应答数据中小端序的 32 位数
+ */
+static uint read_u32(const QByteArray &data, int pos)
+{
+    uint tmp = data[pos] & 0xff;
+    tmp += (data[pos + 1] & 0xff) * 256;
+    tmp += (data[pos + 2] & 0xff) * 65536;
+    tmp += (data[pos + 3] & 0xff) * 16777216;
+    return tmp;
+}
+
+/* 发送缓存至少能放下一个最长的长帧, 否则一帧也写不下 */
+static_assert(FRAME_ENCODER_SIZE >= FRAME_EXT_HEAD + PACK_FRAME_DATA_MAX + FRAME_EOC, "FRAME_ENCODER_SIZE too small");
+
+/**
+ * @brief 烧写帧编码后的长度, 包括指令, 数据长度与 EOC
+ */
+static int encoded_size(const PackedFrame &f)
+{
+    switch(f.cmd)
+    {
+    case PROTO_PROG_SKIP:
+        return FrameEncoder::param_size(1);
+    case PROTO_PROG_LZ:
+        return FrameEncoder::data_size(f.data_len);
+    case PROTO_PROG_MULTI_EXT:
+        return FrameEncoder::ext_size(f.len);
+    default:
+        return FrameEncoder::data_size(f.len);
+    }
+}
+
+FlashEngine::FlashEngine(QObject *parent) :
+    QObject(parent)
+{
+    /* 串口及定时器均以本对象为父对象, 随本对象一起移动到工作线程 */
+    serial = new QSerialPort(this);
+    serial->setReadBufferSize(SerialPortBufferSize);
+
+    timeout_timer = new QTimer(this);
+    timeout_timer->setSingleShot(true);
+
+    tick_timer = new QTimer(this);
+    tick_timer->setInterval(TICK_INTERVAL);
+
+    qRegisterMetaType<DeviceInfo>("DeviceInfo");
+    qRegisterMetaType<FirmwareImage>("FirmwareImage");
+
+    connect(serial, &QSerialPort::readyRead, this, &FlashEngine::on_ready_read);
+    connect(serial, &QSerialPort::bytesWritten, this, &FlashEngine::on_bytes_written);
+    connect(timeout_timer, &QTimer::timeout, this, &FlashEngine::on_timeout);
+    connect(tick_timer, &QTimer::timeout, this, &FlashEngine::on_tick);
+
+    packer = new FramePacker(this);
+    connect(packer, &FramePacker::ready, this, &FlashEngine::on_pack_ready, Qt::QueuedConnection);
+
+    baudrate_list[0] = 256000;
+    baudrate_list[1] = 115200;
+    baudrate_list[2] = 57600;
+    baudrate_list[3] = 38400;
+    baudrate_list[4] = 19200;
+    baudrate_list[5] = 14400;
+    baudrate_list[6] = 9600;
+
+    high_baud_list[0] = 3000000;
+    high_baud_list[1] = 2000000;
+    high_baud_list[2] = 1500000;
+    high_baud_list[3] = 1000000;
+    high_baud_list[4] = 921600;
+    high_baud_list[5] = 460800;
+    high_baud_list[6] = 230400;
+
+    op = OP_NONE;
+    step = STEP_IDLE;
+    step_start = 0;
+    cur_timeout = 0;
+    wait_cmd = 0;
+    frame_time.resize(PROG_WINDOW_MAX);
+    frame_len.resize(PROG_WINDOW_MAX);
+    frame_cmd.resize(PROG_WINDOW_MAX);
+    link_clock.start();
+    tick_max = 0;
+    baud_index = 0;
+    max_baudrate = MAX_BAUD_DEFAULT;
+    sync_baud = 0;
+    sync_cached = false;
+    detect_fallback = 0;
+    high_index = 0;
+    confirm_count = 0;
+    query_index = 0;
+    fw_size = 0;
+    prog_window = PROG_WINDOW_DEFAULT;
+    sent = 0;
+    acked = 0;
+    msg_sent = 0;
+    msg_acked = 0;
+    skip_blank = true;
+    skip_support = -1;
+    compress = true;
+    use_lz = false;
+    max_frame = 0;
+    frame_data = PACK_FRAME_DATA;
+    resume = true;
+    resume_track = false;
+    resume_pos = -1;
+    crc_expect = 0;
+    full_program = true;
+    prog_base = 0;
+    prog_end = 0;
+    sector_index = 0;
+    dirty_index = 0;
+    segment_index = 0;
+}
+
+FlashEngine::~FlashEngine()
+{
+    if(serial->isOpen())
+        serial->close();
+}
+
+/**
+ * @brief 设置烧写滑动窗口大小
+ * @param [in] window int. 最多未确认帧数, 为 1 时退化为逐帧应答
+ */
+void FlashEngine::set_prog_window(int window)
+{
+    if(window < 1)
+        window = 1;
+    if(window > PROG_WINDOW_MAX)
+        window = PROG_WINDOW_MAX;
+
+    prog_window = window;
+}
+
+/**
+ * @brief 设置同步后协商的最高波特率
+ * @param [in] baudrate int. 最高波特率, 为 0 时不协商, 使用同步时的波特率
+ */
+void FlashEngine::set_max_baudrate(int baudrate)
+{
+    max_baudrate = (baudrate < 0) ? 0 : baudrate;
+}
+
+/**
+ * @brief 设置是否跳过空白帧
+ * @param [in] enable bool. 为 true 时擦除后全为 0xFF 的帧不发送, 只移动设备的编程指针
+ */
+void FlashEngine::set_skip_blank(bool enable)
+{
+    skip_blank = enable;
+}
+
+/**
+ * @brief 设置是否使用压缩帧
+ * @param [in] enable bool. 为 true 时设备支持 PROTO_PROG_LZ 则压缩发送
+ */
+void FlashEngine::set_compress(bool enable)
+{
+    compress = enable;
+}
+
+/**
+ * @brief 设置烧写帧的最大数据长度, 用于接收缓存较小的串口适配器
+ * @param [in] bytes int. 最大数据长度, 为 0 时按设备支持的长度
+ */
+void FlashEngine::set_max_frame(int bytes)
+{
+    max_frame = (bytes < 0) ? 0 : bytes;
+}
+
+/**
+ * @brief 设置整片烧写中断后是否从断点继续
+ * @param [in] enable bool. 为 true 时记录断点, 下次烧写同一固件时校验已烧写的部分后继续, 不重新擦除
+ */
+void FlashEngine::set_resume(bool enable)
+{
+    resume = enable;
+}
+
+/**
+ * @brief 开始或停止跟踪每条指令的收发时刻, 开始时清空之前的记录
+ */
+void FlashEngine::set_trace(bool enable)
+{
+    trace.enable(enable ? TRACE_EVENTS_DEFAULT : 0);
+}
+
+/**
+ * @brief 将跟踪记录导出为 Chrome trace JSON, 失败时以 warning 提示
+ * @param [in] path QString. 文件路径
+ */
+void FlashEngine::save_trace(QString path)
+{
+    if(!trace.enabled())
+        return;
+
+    if(!trace.save_json(path, &FlashEngine::phase_name))
+        emit warning("跟踪记录保存失败: " + trace.error_string());
+}
+
+/**
+ * @brief 打开串口并连接设备
+ * @param [in] port_name QString. 串口名
+ * @param [in] baudrate int. 波特率, 为 0 时自动探测
+ */
+void FlashEngine::open_device(QString port_name, int baudrate)
+{
+    if(op != OP_NONE)
+        return;
+
+    /* 设定串口参数 */
+    serial->setPortName(port_name);
+    serial->setDataBits(QSerialPort::Data8);
+    serial->setParity(QSerialPort::NoParity);
+    serial->setStopBits(QSerialPort::OneStop);
+    serial->setFlowControl(QSerialPort::NoFlowControl);
+
+    /* 尝试开启串口 */
+    if(serial->open(QIODevice::ReadWrite) != true)
+    {
+        emit finished(OP_CONNECT, false, "该串口不存在或已被占用");
+        return;
+    }
+
+    start_op(OP_CONNECT);
+    skip_support = -1;
+    link.reset();
+    trace.reset_link();
+
+    if(baudrate == 0)
+    {
+        /* 先尝试该串口及已知设备上次成功的波特率, 最后尝试设备可能仍停留在的协商波特率 */
+        detect_list = BaudCache::candidates(port_name, baudrate_list, BaudRate_Num);
+        detect_fallback = detect_list.size();
+        for(int i = HighBaud_Num - 1; i >= 0; i--)
+        {
+            if(!detect_list.contains(high_baud_list[i]))
+                detect_list.append(high_baud_list[i]);
+        }
+        baud_index = 0;
+        qDebug()<<"try"<<detect_list.at(baud_index);
+        set_baud(detect_list.at(baud_index));
+        start_step(STEP_DETECT, PROTO_GET_SYNC, 50);
+    }
+    else
+    {
+        set_baud(baudrate);
+        start_step(STEP_SYNC, PROTO_GET_SYNC, 50);
+    }
+}
+
+/**
+* @brief  切换串口波特率, 之前的链路计时不再适用, 一并清除
+* @param  [in] baudrate int. 波特率
+* @return 本机串口是否支持
+*/
+bool FlashEngine::set_baud(int baudrate)
+{
+    link.reset();
+    return serial->setBaudRate(baudrate);
+}
+
+/**
+ * @brief 关闭串口, 正在进行的操作将被中止
+ */
+void FlashEngine::close_device(void)
+{
+    if(op != OP_NONE)
+        finish_op(false, "操作已取消");
+
+    if(serial->isOpen())
+        serial->close();
+
+    emit device_closed();
+}
+
+/**
+ * @brief 擦除APP
+ */
+void FlashEngine::erase(void)
+{
+    if((op != OP_NONE) || !serial->isOpen())
+        return;
+
+    start_op(OP_ERASE);
+    start_step(STEP_ERASE, PROTO_CHIP_ERASE, MAX_ERASE_TIME * 10);
+}
+
+/**
+ * @brief 擦除并烧写固件, 完成后校验CRC
+ * @param [in] data QByteArray. 固件数据
+ */
+void FlashEngine::program(QByteArray data)
+{
+    if((op != OP_NONE) || !serial->isOpen())
+        return;
+
+    image = FirmwareImage(data);
+    begin_program(OP_PROGRAM);
+}
+
+/**
+ * @brief 擦除并烧写已打开的固件, 多个会话共用同一份映射与预先计算的CRC
+ * @param [in] image FirmwareImage. 固件
+ */
+void FlashEngine::program_image(FirmwareImage image)
+{
+    if((op != OP_NONE) || !serial->isOpen())
+        return;
+
+    this->image = image;
+    begin_program(OP_PROGRAM);
+}
+
+/**
+ * @brief 擦除并烧写固件文件, 文件映射到内存后直接发送, 不读入内存
+ * @note  HEX, S-record 及 ELF 文件只发送其中有数据的段, 段之间的空隙保持擦除后的 0xFF
+ * @param [in] path QString. 固件文件路径
+ */
+void FlashEngine::program_file(QString path)
+{
+    if((op != OP_NONE) || !serial->isOpen())
+        return;
+
+    if(SparseImage::is_sparse_file(path))
+    {
+        if(load_sparse(OP_PROGRAM, path))
+            begin_program(OP_PROGRAM);
+        return;
+    }
+
+    if(!image.open(path))
+    {
+        emit finished(OP_PROGRAM, false, image.error_string());
+        return;
+    }
+
+    begin_program(OP_PROGRAM);
+}
+
+/**
+ * @brief 增量烧写: 比较每个扇区的CRC, 只擦除并烧写不一致的扇区, 完成后校验整个固件区
+ * @note  设备不支持扇区指令或未提供可用的扇区结构时, 改为整片擦除烧写
+ * @param [in] data QByteArray. 固件数据
+ */
+void FlashEngine::update(QByteArray data)
+{
+    if((op != OP_NONE) || !serial->isOpen())
+        return;
+
+    image = FirmwareImage(data);
+    begin_program(OP_UPDATE);
+}
+
+/**
+ * @brief 增量烧写固件文件
+ * @param [in] path QString. 固件文件路径
+ */
+void FlashEngine::update_file(QString path)
+{
+    if((op != OP_NONE) || !serial->isOpen())
+        return;
+
+    if(SparseImage::is_sparse_file(path))
+    {
+        if(load_sparse(OP_UPDATE, path))
+            begin_program(OP_UPDATE);
+        return;
+    }
+
+    if(!image.open(path))
+    {
+        emit finished(OP_UPDATE, false, image.error_string());
+        return;
+    }
+
+    begin_program(OP_UPDATE);
+}
+
+/**
+ * @brief 检查固件后开始整片烧写或增量烧写
+ * @param [in] operation int. OP_PROGRAM 或 OP_UPDATE
+ */
+void FlashEngine::begin_program(int operation)
+{
+    if(check_image(operation, image.size()) == false)
+    {
+        image.close();
+        segments.clear();
+        return;
+    }
+
+    start_op(operation);
+
+    if((operation == OP_PROGRAM) || fw_sectors.isEmpty())
+    {
+        if(operation == OP_UPDATE)
+            qDebug() << "no usable flash structure, full program";
+        if(!start_resume())
+            start_full_erase();
+        return;
+    }
+
+    full_program = false;
+    dirty.clear();
+    sector_index = 0;
+    send_range_crc();
+}
+
+/**
+* @brief  检查固件是否可以烧写
+* @return 是否通过
+*/
+bool FlashEngine::check_image(int operation, qint64 filelen)
+{
+    qDebug() << "文件大小" << filelen << "字节";
+
+    if(filelen % 4 != 0)
+    {
+        emit finished(operation, false, "文件非法，长度不符合4字节的倍数");
+        return false;
+    }
+    if(filelen > fw_size)
+    {
+        emit finished(operation, false, "文件超过固件区大小");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+* @brief  读取带地址的固件文件, 地址按设备的 FLASH 结构换算为固件区内的偏移
+* @note   整片烧写时各段数据依次存入 image 并记录在 segments 中;
+*         增量烧写需要按扇区比较, 展开为从固件区起始处开始的连续数据, 空隙填充 0xFF
+* @param  [in] operation int. OP_PROGRAM 或 OP_UPDATE
+* @param  [in] path QString. 固件文件路径
+* @return 是否成功
+*/
+bool FlashEngine::load_sparse(int operation, const QString &path)
+{
+    SparseImage sparse;
+    uint base;
+
+    if(!sparse.load(path))
+    {
+        emit finished(operation, false, sparse.error_string());
+        return false;
+    }
+    if(sparse.isEmpty())
+    {
+        emit finished(operation, false, "文件中没有固件数据");
+        return false;
+    }
+    if(!info.layout.fw_start(fw_size, &base))
+    {
+        emit finished(operation, false, "设备未提供FLASH结构, 无法确定固件区地址, 请使用bin文件");
+        return false;
+    }
+
+    /* 烧写以字为单位, 段的首尾补齐到 4 字节 */
+    sparse.align(4, (char)0xff);
+
+    if((sparse.start() < base) || ((qint64)sparse.end() - base > fw_size))
+    {
+        emit finished(operation, false, QString("固件地址超出固件区 0x%1 - 0x%2")
+                      .arg(base, 8, 16, QChar('0')).arg(base + fw_size, 8, 16, QChar('0')));
+        return false;
+    }
+
+    segments.clear();
+
+    if(operation == OP_UPDATE)
+    {
+        image = FirmwareImage(sparse.flatten(base, sparse.end() - base, (char)0xff));
+        return true;
+    }
+
+    const QVector<ImageSegment> &list = sparse.segments();
+    QByteArray data;
+
+    data.reserve(sparse.data_size());
+    for(int i = 0; i < list.size(); i++)
+    {
+        ProgSegment seg;
+
+        seg.offset = list.at(i).address - base;
+        seg.base = data.size();
+        data.append(list.at(i).data);
+        seg.end = data.size();
+        segments.append(seg);
+    }
+
+    qDebug() << "segments" << segments.size() << "data" << data.size();
+    image = FirmwareImage(data);
+    return true;
+}
+
+/**
+ * @brief 开始整片擦除, 擦除完成后烧写整个固件
+ * @note  擦除指令先交给系统发出, 再计算期望的CRC, 计算与设备擦除同时进行, 映射的文件也在此时读入页缓存.
+ *        QSerialPort::write 只把数据放入串口对象的缓存, 要等回到事件循环才写出, 因此立即 flush
+ */
+void FlashEngine::start_full_erase(void)
+{
+    long filelen = image.size();
+
+    full_program = true;
+    resume_pos = -1;
+    start_step(STEP_ERASE, PROTO_CHIP_ERASE, MAX_ERASE_TIME * 10);
+    serial->flush();
+
+    if(!segments.isEmpty())
+    {
+        segment_index = 0;
+        crc_expect = prefix_crc(fw_size);
+        return;
+    }
+
+    set_prog_range(0, filelen);
+    qDebug() << "program" << prog_end << "bytes";
+
+    crc_expect = crc32_fill(0xff, fw_size - filelen, image_crc());
+}
+
+/**
+ * @brief 固件数据的CRC, 已预先计算时直接使用, 否则计算后保存在 image 中供断点与校验共用
+ */
+uint FlashEngine::image_crc(void)
+{
+    if(!image.crc_known())
+        image.set_crc(crc32(image.data(), image.size(), 0));
+
+    return image.crc();
+}
+
+/**
+ * @brief 计算整片烧写后固件区 [0, end) 的CRC, 固件 (或各段之间) 未覆盖的部分按 0xFF 计算
+ */
+uint FlashEngine::prefix_crc(long end)
+{
+    uint crc = 0;
+    long pos = 0;
+
+    if(segments.isEmpty())
+    {
+        pos = qMin(end, (long)image.size());
+        crc = crc32(image.data(), pos, 0);
+        return crc32_fill(0xff, end - pos, crc);
+    }
+
+    for(int i = 0; (i < segments.size()) && ((long)segments.at(i).offset < end); i++)
+    {
+        const ProgSegment &seg = segments.at(i);
+        long len = qMin(seg.end - seg.base, end - (long)seg.offset);
+
+        crc = crc32_fill(0xff, seg.offset - pos, crc);
+        crc = crc32(image.data() + seg.base, len, crc);
+        pos = seg.offset + len;
+    }
+
+    return crc32_fill(0xff, end - pos, crc);
+}
+
+/**
+* @brief  image 中位置 pos 所在的段, 段末尾视为下一段的开始
+* @return 段序号, 不按段烧写时为 0
+*/
+int FlashEngine::segment_of(long pos) const
+{
+    int i = 0;
+
+    while((i + 1 < segments.size()) && (pos >= segments.at(i).end))
+        i++;
+
+    return i;
+}
+
+/**
+ * @brief image 中的位置换算为固件区内的偏移
+ */
+long FlashEngine::dev_offset(long pos) const
+{
+    if(segments.isEmpty())
+        return pos;
+
+    const ProgSegment &seg = segments.at(segment_of(pos));
+    return seg.offset + (pos - seg.base);
+}
+
+/**
+* @brief  固件区内的偏移换算为 image 中的位置
+* @return 位置, 偏移不在任何段内 (含段末尾) 时为 -1
+*/
+long FlashEngine::image_pos(long offset) const
+{
+    if(segments.isEmpty())
+        return (offset <= image.size()) ? offset : -1;
+
+    for(int i = 0; i < segments.size(); i++)
+    {
+        const ProgSegment &seg = segments.at(i);
+
+        if((offset >= (long)seg.offset) && (offset <= (long)seg.offset + (seg.end - seg.base)))
+            return seg.base + (offset - seg.offset);
+    }
+
+    return -1;
+}
+
+/**
+ * @brief 固件摘要, 由固件长度、CRC与各段的地址组成, 用于确认断点属于同一固件
+ * @note  CRC 与整片烧写的校验共用 (多设备烧写时已预先计算), 不再单独遍历固件数据
+ */
+QByteArray FlashEngine::make_digest(void)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    qint64 head[2] = {image.size(), image_crc()};
+
+    hash.addData((const char *)head, sizeof(head));
+    for(int i = 0; i < segments.size(); i++)
+    {
+        const ProgSegment &seg = segments.at(i);
+        long table[3] = {(long)seg.offset, seg.base, seg.end};
+
+        hash.addData((const char *)table, sizeof(table));
+    }
+
+    return hash.result();
+}
+
+/**
+* @brief  整片烧写前查找断点, 有同一固件的断点时读取编程指针, 之后校验已烧写的部分
+* @note   设备中可能已写入尚未确认的帧, 编程指针在断点之后且在同一段内时从编程指针继续,
+*         避免重复写入已编程的字. 已烧写的部分与固件不一致, 或断点之后不是擦除状态
+*         (设备已被其他工具改写) 时仍整片擦除
+* @return 是否从断点继续
+*/
+bool FlashEngine::start_resume(void)
+{
+    image_digest.clear();
+    resume_track = false;
+    resume_pos = -1;
+
+    if(!resume || info.udid.isEmpty())
+        return false;
+
+    /* 先按 UDID 查找, 没有断点时不计算摘要, 中断时由 finish_op 计算 */
+    resume_track = true;
+    QByteArray digest;
+    long pos = ProgResume::load(info.udid, &digest);
+    if((pos <= 0) || (pos > image.size()))
+        return false;
+
+    image_digest = make_digest();
+    if(digest != image_digest)
+        return false;
+
+    qDebug() << "resume from" << pos;
+    full_program = true;
+    resume_pos = pos;
+    crc_expect = prefix_crc(fw_size);
+    start_step(STEP_RESUME_POS, PROTO_GET_PROG_ADDR, 50);
+    return true;
+}
+
+/**
+ * @brief 烧写下一段. 擦除后编程指针位于固件区起始处, 第一段从 0 开始时不必设置
+ */
+void FlashEngine::start_segment(void)
+{
+    const ProgSegment &seg = segments.at(segment_index);
+
+    set_prog_range(seg.base, seg.end);
+
+    if((segment_index == 0) && (seg.offset == 0))
+    {
+        start_program();
+        return;
+    }
+
+    uint param = seg.offset;
+    start_param_step(STEP_SET_ADDR, PROTO_SET_PROG_ADDR, &param, 1, 50);
+}
+
+/**
+ * @brief 设置本次烧写的范围 [base, end)
+ * @note  跳过空白帧时末尾的 0xFF 不必发送, 范围缩短到最后一个非空白字
+ * @param [in] base long. 起始偏移
+ * @param [in] end long. 结束偏移
+ */
+void FlashEngine::set_prog_range(long base, long end)
+{
+    if(end < base)
+        end = base;
+    if(skip_blank)
+        end = base + ((image.trim_blank(base, end) - base + 3) & ~3L);
+
+    prog_base = base;
+    prog_end = end;
+}
+
+/**
+ * @brief 不烧写, 仅校验设备固件区与给定固件是否一致
+ * @param [in] data QByteArray. 固件数据
+ */
+void FlashEngine::verify(QByteArray data)
+{
+    if((op != OP_NONE) || !serial->isOpen())
+        return;
+
+    long filelen = data.size();
+    if(filelen > fw_size)
+    {
+        emit finished(OP_VERIFY, false, "文件超过固件区大小");
+        return;
+    }
+
+    crc_expect = crc32(data.constData(), filelen, 0);
+    crc_expect = crc32_fill(0xff, fw_size - filelen, crc_expect);
+
+    start_op(OP_VERIFY);
+    start_step(STEP_CRC, PROTO_GET_CRC, MAX_CRC_TIME * 10);
+}
+
+/**
+ * @brief 引导APP, 成功后关闭串口
+ */
+void FlashEngine::boot(void)
+{
+    if((op != OP_NONE) || !serial->isOpen())
+        return;
+
+    start_op(OP_BOOT);
+    start_step(STEP_BOOT, PROTO_BOOT, 50);
+}
+
+void FlashEngine::start_op(int operation)
+{
+    op = operation;
+    parser.reset();
+
+    for(int i = 0; i < PHASE_NUM; i++)
+        op_stats.phase_ns[i] = 0;
+    op_stats.frames = 0;
+    op_stats.data_bytes = 0;
+    op_stats.wire_bytes = 0;
+    op_stats.ack_us.clear();
+}
+
+/**
+ * @brief 切换步骤, 上一步骤的耗时计入所属阶段
+ */
+void FlashEngine::set_step(int s)
+{
+    static const signed char phase_of[] =
+    {
+        -1,                 // STEP_IDLE
+        PHASE_SYNC,         // STEP_DETECT
+        PHASE_SYNC,         // STEP_SYNC
+        PHASE_BAUD,         // STEP_SET_BAUD
+        PHASE_BAUD,         // STEP_BAUD_CONFIRM
+        PHASE_BAUD,         // STEP_BAUD_WAIT
+        PHASE_BAUD,         // STEP_BAUD_REVERT
+        PHASE_QUERY,        // STEP_QUERY
+        PHASE_ERASE,        // STEP_ERASE
+        PHASE_PROGRAM,      // STEP_PROGRAM
+        PHASE_CRC,          // STEP_CRC
+        PHASE_CRC,          // STEP_RANGE_CRC
+        PHASE_ERASE,        // STEP_SECTOR_ERASE
+        PHASE_PROGRAM,      // STEP_SET_ADDR
+        PHASE_PROGRAM,      // STEP_SKIP_PROBE
+        PHASE_BOOT,         // STEP_BOOT
+        PHASE_PROGRAM,      // STEP_RESUME_POS
+        PHASE_CRC,          // STEP_RESUME_CRC
+        PHASE_CRC,          // STEP_RESUME_BLANK
+        PHASE_PROGRAM       // STEP_RESUME_ADDR
+    };
+    qint64 t = link_clock.nsecsElapsed();
+
+    if(phase_of[step] >= 0)
+        op_stats.phase_ns[(int)phase_of[step]] += t - step_start;
+
+    step = s;
+    step_start = t;
+    trace.step(phase_of[s]);
+}
+
+const char *FlashEngine::phase_name(int phase)
+{
+    static const char *names[PHASE_NUM] = {"sync", "baud", "query", "erase", "program", "crc", "boot"};
+
+    return ((phase >= 0) && (phase < PHASE_NUM)) ? names[phase] : "";
+}
+
+void FlashEngine::finish_op(bool ok, QString msg)
+{
+    int o = op;
+
+    timeout_timer->stop();
+    tick_timer->stop();
+    op = OP_NONE;
+    set_step(STEP_IDLE);
+    packer->stop();
+
+    /*
+     * 整片烧写: 中断时记录最新确认的位置 (包括从断点继续后再次中断), 完成或设备内容未知时删除.
+     * 下次继续前会校验已烧写部分的CRC并确认其后仍为擦除状态, 过时的断点只会导致整片擦除
+    */
+    if(resume_track)
+    {
+        if(!ok && (resume_pos > 0))
+            ProgResume::save(info.udid, image_digest.isEmpty() ? make_digest() : image_digest, resume_pos);
+        else
+            ProgResume::clear(info.udid);
+        image_digest.clear();
+        resume_track = false;
+    }
+    image.close();
+    segments.clear();
+
+    emit finished(o, ok, msg);
+}
+
+/**
+ * @brief 进入新的步骤并发送对应指令
+ * @param [in] s int. 步骤
+ * @param [in] cmd int. 指令
+ * @param [in] timeout int. 超时时间, 单位 ms
+ */
+void FlashEngine::start_step(int s, int cmd, int timeout)
+{
+    set_step(s);
+
+    /* 擦除与校验耗时较长, 按预计时间刷新进度 */
+    if((s == STEP_ERASE) || (s == STEP_CRC))
+    {
+        tick_max = link.estimate(cmd, timeout) / 10;
+        step_time.start();
+        emit progress(0, tick_max);
+        tick_timer->start();
+    }
+    else
+    {
+        tick_timer->stop();
+    }
+
+    send_normal_cmd(cmd, timeout);
+}
+
+/**
+ * @brief 发送无参数指令并开始等待应答
+ * @note  应答到达即处理, timeout 仅为等待上限
+ */
+void FlashEngine::send_normal_cmd(int cmd, int timeout)
+{
+    parser.expect(ReplyParser::reply_length(cmd));
+    serial->clear(QSerialPort::Input);
+    trace.discard_replies();
+
+    tx.clear();
+    trace.queued(cmd, tx.put_cmd(cmd));
+    tx.flush(serial);
+
+    start_wait(cmd, timeout);
+}
+
+/**
+ * @brief 开始等待应答
+ * @note  探测性的等待 (探测波特率, 确认波特率切换) 超时即为结果, 使用统计得到的超时时间;
+ *        其余指令 (包括读取设备信息) 必须应答, 超时时间不短于默认值, 链路较慢时按统计值延长
+ * @param [in] cmd int. 指令
+ * @param [in] def int. 默认超时时间, 单位 ms
+ */
+void FlashEngine::start_wait(int cmd, int def)
+{
+    int rto = link.timeout(cmd, def);
+
+    if((step == STEP_DETECT) || (step == STEP_BAUD_CONFIRM))
+        cur_timeout = rto;
+    else
+        cur_timeout = qMax(def, rto);
+
+    wait_cmd = cmd;
+    wait_time.start();
+    timeout_timer->start(cur_timeout);
+}
+
+/**
+ * @brief 发送带参数的指令并开始等待应答, 格式为 指令 + 参数长度 + 参数 + EOC
+ * @param [in] s int. 步骤
+ * @param [in] cmd int. 指令
+ * @param [in] param const uint*. 参数, 以小端序发送
+ * @param [in] num int. 参数个数
+ * @param [in] timeout int. 超时时间, 单位 ms
+ */
+void FlashEngine::start_param_step(int s, int cmd, const uint *param, int num, int timeout)
+{
+    set_step(s);
+    tick_timer->stop();
+
+    parser.expect(ReplyParser::reply_length(cmd));
+    serial->clear(QSerialPort::Input);
+    trace.discard_replies();
+
+    tx.clear();
+    trace.queued(cmd, tx.put_param(cmd, param, num));
+    tx.flush(serial);
+
+    start_wait(cmd, timeout);
+}
+
+/**
+ * @brief 读取当前扇区的CRC
+ */
+void FlashEngine::send_range_crc(void)
+{
+    const FlashSector &sec = fw_sectors.at(sector_index);
+    uint param[2] = {sec.address, sec.size};
+
+    emit progress(sector_index, fw_sectors.size());
+    start_param_step(STEP_RANGE_CRC, PROTO_GET_RANGE_CRC, param, 2, MAX_CRC_TIME * 10);
+}
+
+/**
+ * @brief 擦除下一个不一致的扇区
+ */
+void FlashEngine::erase_dirty(void)
+{
+    const FlashSector &sec = fw_sectors.at(dirty.at(dirty_index));
+    uint param[2] = {sec.address, sec.size};
+
+    qDebug() << "update sector" << dirty.at(dirty_index);
+    start_param_step(STEP_SECTOR_ERASE, PROTO_SECTOR_ERASE, param, 2, MAX_ERASE_TIME * 10);
+
+    set_prog_range(sec.address, qMin((long)(sec.address + sec.size), (long)image.size()));
+}
+
+/**
+ * @brief 计算固件在某个扇区内的CRC, 固件未覆盖的部分按 0xFF 计算
+ */
+uint FlashEngine::sector_crc(const FlashSector &sec)
+{
+    long filelen = image.size();
+    long start = sec.address;
+    long end = qMin((long)(sec.address + sec.size), filelen);
+    uint crc = 0;
+
+    if(start < end)
+        crc = crc32(image.data() + start, end - start, crc);
+    else
+        end = start;
+
+    return crc32_fill(0xff, sec.size - (end - start), crc);
+}
+
+/**
+ * @brief 增量烧写全部完成, 校验整个固件区
+ */
+void FlashEngine::start_final_crc(void)
+{
+    long filelen = image.size();
+
+    crc_expect = crc32_fill(0xff, fw_size - filelen, image_crc());
+    start_step(STEP_CRC, PROTO_GET_CRC, MAX_CRC_TIME * 10);
+}
+
+/**
+ * @brief 在窗口未满时持续发送烧写帧
+ * @note  压缩时帧由 packer 在工作线程中预先生成, 尚未生成时停止发送, 生成后由 on_pack_ready 继续.
+ *        本次可发送的帧在发送缓存中连续组帧后一次写入串口
+ */
+void FlashEngine::send_frames(void)
+{
+    tx.clear();
+
+    while ((prog_base + sent < prog_end) && (msg_sent - msg_acked < prog_window))
+    {
+        PackedFrame f;
+        int wire_len;
+
+        if(use_lz)
+        {
+            if(!packer->take(&f))
+                break;
+        }
+        else
+        {
+            FramePacker::plan(image, prog_base + sent, prog_end, skip_support == 1, frame_data, &f);
+        }
+
+        if(!tx.fits(encoded_size(f)))
+            tx.flush(serial);
+
+        if(f.cmd == PROTO_PROG_SKIP)
+        {
+            uint len = f.len;
+            wire_len = tx.put_param(PROTO_PROG_SKIP, &len, 1);
+        }
+        else if(f.cmd == PROTO_PROG_LZ)
+        {
+            wire_len = tx.put_data(PROTO_PROG_LZ, f.data, f.data_len);
+        }
+        else if(f.cmd == PROTO_PROG_MULTI_EXT)
+        {
+            wire_len = tx.put_data_ext(PROTO_PROG_MULTI_EXT, image.data() + f.pos, f.len);
+        }
+        else
+        {
+            wire_len = tx.put_data(PROTO_PROG_MULTI, image.data() + f.pos, f.len);
+        }
+        trace.queued(f.cmd, wire_len);
+
+        int slot = msg_sent % frame_time.size();
+        frame_time[slot] = link_clock.nsecsElapsed() / 1000;
+        frame_len[slot] = f.len;
+        frame_cmd[slot] = f.cmd;
+        msg_sent++;
+        sent += f.len;
+        op_stats.frames++;
+        op_stats.wire_bytes += wire_len;
+    }
+
+    tx.flush(serial);
+}
+
+/**
+ * @brief 压缩线程生成了新的帧. 窗口中没有未确认的帧时, 超时从此时重新计算
+ */
+void FlashEngine::on_pack_ready(void)
+{
+    if(step != STEP_PROGRAM)
+        return;
+
+    bool idle = (msg_sent == msg_acked);
+
+    send_frames();
+    if(idle && (msg_sent != msg_acked))
+        start_wait(PROTO_PROG_MULTI, prog_ack_timeout());
+}
+
+void FlashEngine::on_ready_read(void)
+{
+    char chunk[SerialPortBufferSize];
+    qint64 len;
+
+    while((len = serial->read(chunk, sizeof(chunk))) > 0)
+    {
+        if(step == STEP_IDLE)
+            continue;
+
+        if(parse_replies(chunk, len) == false)
+            return;
+    }
+}
+
+/**
+* @brief  解析收到的数据并依次处理其中的应答
+* @param  [in] p const char*. 收到的数据
+* @param  [in] len qint64. 数据长度, 为 0 时只处理解析器中保留的数据
+* @return 是否继续读取后续数据
+*/
+bool FlashEngine::parse_replies(const char *p, qint64 len)
+{
+    for(;;)
+    {
+        int used = 0;
+
+        if(len > 0)
+            trace.reply_data();
+        int result = parser.feed(p, len, &used);
+        p += used;
+        len -= used;
+
+        if(result == REPLY_TIMEOUT)
+            return true;
+
+        trace.reply(result);
+
+        if(step == STEP_PROGRAM)
+        {
+            if(process_ack(result) == false)
+                return false;
+            continue;
+        }
+
+        /* 只统计正确的应答, 错误波特率下的乱码偶尔也会被解析为应答 */
+        timeout_timer->stop();
+        if((result == REPLY_OK) && (step != STEP_BAUD_WAIT))
+            link.sample(wait_cmd, wait_time.nsecsElapsed() / 1000);
+
+        if(step == STEP_QUERY)
+        {
+            if(process_query(result, QByteArray(parser.payload(), parser.payload_len())) == false)
+                return false;
+            continue;
+        }
+
+        /* 应答处理中可能已发出下一条指令, 之后的数据均属于上一条指令, 丢弃 */
+        handle_reply(result, QByteArray(parser.payload(), parser.payload_len()));
+        return true;
+    }
+}
+
+/**
+ * @brief 数据全部写出后重新开始计时, 使超时时间不包含主机端的发送排队时间
+ */
+void FlashEngine::on_bytes_written(qint64 bytes)
+{
+    trace.written(bytes);
+
+    if(timeout_timer->isActive() && (serial->bytesToWrite() == 0))
+    {
+        wait_time.start();
+        timeout_timer->start(cur_timeout);
+    }
+}
+
+void FlashEngine::on_timeout(void)
+{
+    /* 定长应答开头的错误状态要等到超时才能确认, 确认后按收到的应答处理 */
+    if(parser.flush())
+    {
+        parse_replies(NULL, 0);
+        return;
+    }
+
+    trace.reply(REPLY_TIMEOUT);
+    handle_reply(REPLY_TIMEOUT, QByteArray());
+}
+
+void FlashEngine::on_tick(void)
+{
+    int value = step_time.elapsed() / 10;
+    if(value > tick_max)
+        value = tick_max;
+
+    emit progress(value, tick_max);
+}
+
+/**
+ * @brief 按顺序确认烧写帧
+ * @param [in] result int. 应答结果
+ * @return 是否继续处理后续应答
+ */
+bool FlashEngine::process_ack(int result)
+{
+    if(result != REPLY_OK)
+    {
+        finish_op(false, reply_text(result));
+        return false;
+    }
+
+    /* 帧在发送队列中的等待时间也计入, 窗口较大或波特率较低时超时时间随之延长 */
+    int slot = msg_acked % frame_time.size();
+
+    int rtt = link_clock.nsecsElapsed() / 1000 - frame_time[slot];
+
+    link.sample(frame_cmd[slot], rtt);
+    op_stats.ack_us.append(rtt);
+    msg_acked++;
+    acked += frame_len[slot];
+    if(full_program)
+        resume_pos = prog_base + acked;
+    op_stats.data_bytes += frame_len[slot];
+    emit progress(acked, prog_end - prog_base);
+
+    if(prog_base + acked < prog_end)
+    {
+        send_frames();
+        start_wait(PROTO_PROG_MULTI, prog_ack_timeout());
+        return true;
+    }
+
+    program_done();
+    return false;
+}
+
+/**
+ * @brief 烧写应答的超时时间, 长帧时加上一个窗口的帧在当前波特率下的传输时间
+ * @return 超时时间, 单位 ms
+ */
+int FlashEngine::prog_ack_timeout(void) const
+{
+    int baud = serial->baudRate();
+    qint64 bytes = (qint64)(frame_data + 4) * prog_window;
+
+    return PROG_ACK_TIMEOUT + ((baud > 0) ? (int)(bytes * 10 * 1000 / baud) : 0);
+}
+
+/**
+ * @brief 当前范围烧写完成, 继续下一个扇区或下一段, 全部完成后校验CRC
+ */
+void FlashEngine::program_done(void)
+{
+    packer->stop();
+
+    /* 增量烧写: 继续下一个不一致的扇区 */
+    if(!full_program)
+    {
+        if(++dirty_index < dirty.size())
+            erase_dirty();
+        else
+            start_final_crc();
+        return;
+    }
+
+    /* 按段烧写: 继续下一段 */
+    if(!segments.isEmpty() && (++segment_index < segments.size()))
+    {
+        start_segment();
+        return;
+    }
+
+    qDebug() << "flash ok";
+
+    /*
+     * CRC校验, 期望值已在擦除期间算出
+    */
+    start_step(STEP_CRC, PROTO_GET_CRC, MAX_CRC_TIME * 10);
+}
+
+/**
+ * @brief 开始烧写当前范围. 范围全为 0xFF 时直接完成; 第一次使用跳过指令前先确认设备支持.
+ *        使用压缩帧时压缩线程与发送同时进行
+ */
+void FlashEngine::start_program(void)
+{
+    if(prog_end == prog_base)
+    {
+        program_done();
+        return;
+    }
+
+    if(skip_blank && (skip_support < 0))
+    {
+        uint zero = 0;
+        start_param_step(STEP_SKIP_PROBE, PROTO_PROG_SKIP, &zero, 1, 50);
+        return;
+    }
+
+    sent = 0;
+    acked = 0;
+    msg_sent = 0;
+    msg_acked = 0;
+
+    /*
+     * 数据帧长度: 不支持查询的旧设备为 252 字节; 设备支持更长的帧时使用长帧, 不超过 PACK_FRAME_DATA_MAX.
+     * 压缩帧只能覆盖完整的数据帧以上的长度, 解压缓冲区不大于一帧时不压缩
+    */
+    int limit = (info.frame_max > 0) ? (int)qMin(info.frame_max, (uint)PACK_FRAME_DATA_MAX) : PACK_FRAME_DATA;
+    if(limit <= 255)
+        limit = qMin(limit, PACK_FRAME_DATA);
+    if(max_frame > 0)
+        limit = qMin(limit, max_frame);
+    frame_data = qMax(limit & ~3, 4);
+
+    use_lz = compress && (info.caps & PROTO_CAP_LZ) && ((int)info.lz_block > frame_data);
+    if(use_lz)
+        packer->start_pack(image, prog_base, prog_end, skip_support == 1, frame_data, info.lz_block);
+
+    set_step(STEP_PROGRAM);
+    tick_timer->stop();
+    emit progress(0, prog_end - prog_base);
+
+    parser.expect(ReplyParser::reply_length(PROTO_PROG_MULTI));
+    serial->clear(QSerialPort::Input);
+    trace.discard_replies();
+
+    send_frames();
+    start_wait(PROTO_PROG_MULTI, prog_ack_timeout());
+}
+
+/**
+ * @brief 同步成功后从高到低尝试切换到更高的波特率, 全部失败时保持同步时的波特率
+ */
+void FlashEngine::next_baud(void)
+{
+    while(high_index < HighBaud_Num)
+    {
+        uint baud = high_baud_list[high_index];
+
+        if(((int)baud > sync_baud) && ((int)baud <= max_baudrate))
+        {
+            qDebug() << "set baudrate" << baud;
+            start_param_step(STEP_SET_BAUD, PROTO_SET_BAUD, &baud, 1, 50);
+            return;
+        }
+
+        high_index++;
+    }
+
+    query_index = 0;
+    send_queries();
+}
+
+/**
+ * @brief 切换失败后等待设备超时恢复原波特率
+ */
+void FlashEngine::wait_baud_revert(void)
+{
+    set_step(STEP_BAUD_WAIT);
+    tick_timer->stop();
+    parser.expect(0);
+    serial->clear(QSerialPort::Input);
+    trace.discard_replies();
+
+    cur_timeout = PROTO_BAUD_REVERT_TIME + 100;
+    timeout_timer->start(cur_timeout);
+}
+
+/**
+ * @brief 连续发出剩余的全部查询指令, 应答由 process_query 按顺序处理
+ */
+void FlashEngine::send_queries(void)
+{
+    if(query_index == 0)
+        info = DeviceInfo();
+
+    set_step(STEP_QUERY);
+    tick_timer->stop();
+
+    parser.expect(ReplyParser::reply_length(query_list[query_index][0]));
+    serial->clear(QSerialPort::Input);
+    trace.discard_replies();
+
+    tx.clear();
+    for(int i = query_index; i < QUERY_NUM; i++)
+        trace.queued(query_list[i][0], tx.put_cmd(query_list[i][0]));
+    tx.flush(serial);
+
+    /* 在所有指令发送完之前, on_bytes_written 会按最新的 cur_timeout 重新计时 */
+    start_wait(query_list[query_index][0], query_list[query_index][1]);
+}
+
+/**
+* @brief  处理一个查询应答, 并开始等待下一个
+* @param  [in] result int. 应答结果
+* @param  [in] data QByteArray. 应答数据
+* @return 是否继续处理后续应答
+*/
+bool FlashEngine::process_query(int result, QByteArray data)
+{
+    int cmd = query_list[query_index][0];
+
+    if(result == REPLY_OK)
+    {
+        switch(cmd)
+        {
+        case PROTO_GET_UDID:
+            info.udid = data;
+            if(sync_cached)
+                BaudCache::udid_ok(data, sync_baud);
+            break;
+        case PROTO_GET_FW_SIZE:
+        {
+            uint tmp = data[0] & 0xff;
+            tmp += (data[1] & 0xff) * 256;
+            tmp += (data[2] & 0xff) * 65536;
+            tmp += (data[3] & 0xff) * 16777216;
+            info.fw_size = tmp;
+            fw_size = tmp;
+            break;
+        }
+        case PROTO_GET_BL_REV:
+            info.bl_rev = data;
+            break;
+        case PROTO_GET_ID:
+            info.id = data;
+            break;
+        case PROTO_GET_SN:
+            info.sn = data;
+            break;
+        case PROTO_GET_REV:
+            info.rev = data;
+            break;
+        case PROTO_GET_DES:
+            info.des = data;
+            break;
+        case PROTO_GET_FLASH_STRC:
+            info.flash_strc = data;
+            info.layout.parse(data);
+            fw_sectors = info.layout.fw_area(fw_size);
+            break;
+        case PROTO_GET_CAPS:
+            info.caps = read_u32(data, 0);
+            info.lz_block = read_u32(data, 4);
+            break;
+        case PROTO_GET_FRAME_MAX:
+            info.frame_max = read_u32(data, 0);
+            break;
+        default:
+            break;
+        }
+    }
+    else if(((cmd != PROTO_GET_CAPS) && (cmd != PROTO_GET_FRAME_MAX)) || (result != REPLY_INVALID))
+    {
+        /* 旧版 bootloader 不支持扩展功能与帧长查询, 不必提示 */
+        emit warning(reply_text(result));
+    }
+
+    if(++query_index >= QUERY_NUM)
+    {
+        query_done();
+        return false;
+    }
+
+    /* 设备按顺序处理, 下一个应答的处理时间从上一个应答到达时开始计算 */
+    parser.expect_next(ReplyParser::reply_length(query_list[query_index][0]));
+    start_wait(query_list[query_index][0], query_list[query_index][1]);
+    return true;
+}
+
+void FlashEngine::query_done(void)
+{
+    emit device_ready(info);
+    finish_op(true, "");
+}
+
+/**
+ * @brief 处理应答并推进当前操作
+ * @param [in] result int. 0,超时.1,正确.2,无效.3,失败
+ * @param [in] data QByteArray. 应答数据
+ */
+void FlashEngine::handle_reply(int result, QByteArray data)
+{
+    switch(step)
+    {
+    case STEP_DETECT:
+        if(result == REPLY_OK)
+        {
+            qDebug()<<"found baudrate"<<detect_list.at(baud_index);
+            sync_baud = detect_list.at(baud_index);
+
+            /* 设备停留在上次协商的波特率时只是未复位, 复位后不会在该波特率下应答, 不记录 */
+            sync_cached = (baud_index < detect_fallback);
+            if(sync_cached)
+                BaudCache::port_ok(serial->portName(), sync_baud);
+            if(baud_index > 0)
+                BaudCache::bauds_failed(detect_list.mid(0, qMin(baud_index, detect_fallback)));
+            high_index = 0;
+            next_baud();
+            break;
+        }
+
+        if(++baud_index < detect_list.size())
+        {
+            qDebug()<<"try"<<detect_list.at(baud_index);
+            set_baud(detect_list.at(baud_index));
+            start_step(STEP_DETECT, PROTO_GET_SYNC, 50);
+            break;
+        }
+
+        qDebug()<<"baudrate not found !"<<detect_list.size();
+        BaudCache::port_failed(serial->portName());
+        serial->close();
+        finish_op(false, "该未发现合适的串口频率,请确认设备是否正确连接并运行");
+        break;
+
+    case STEP_SYNC:
+        if(result == REPLY_OK)
+        {
+            BaudCache::port_ok(serial->portName(), serial->baudRate());
+            sync_baud = serial->baudRate();
+            sync_cached = true;
+            high_index = 0;
+            next_baud();
+            break;
+        }
+
+        serial->close();
+        finish_op(false, "同步失败");
+        break;
+
+    case STEP_SET_BAUD:
+        if(result == REPLY_OK)
+        {
+            confirm_count = 0;
+            if(set_baud(high_baud_list[high_index]))
+            {
+                start_step(STEP_BAUD_CONFIRM, PROTO_GET_SYNC, 50);
+                break;
+            }
+
+            /* 本机串口不支持该波特率, 等待设备恢复 */
+            set_baud(sync_baud);
+            wait_baud_revert();
+            break;
+        }
+
+        /* 设备不支持该波特率, 尝试下一个 */
+        if(result == REPLY_FAILED)
+        {
+            high_index++;
+            next_baud();
+            break;
+        }
+
+        /* 无应答时无法确定设备是否已切换 */
+        if(result == REPLY_TIMEOUT)
+        {
+            wait_baud_revert();
+            break;
+        }
+
+        /* 旧版 bootloader 不支持切换波特率 */
+        query_index = 0;
+        send_queries();
+        break;
+
+    case STEP_BAUD_CONFIRM:
+        if(result == REPLY_OK)
+        {
+            qDebug() << "baudrate switched to" << high_baud_list[high_index];
+            query_index = 0;
+            send_queries();
+            break;
+        }
+
+        if(++confirm_count < BAUD_CONFIRM_TRIES)
+        {
+            start_step(STEP_BAUD_CONFIRM, PROTO_GET_SYNC, 50);
+            break;
+        }
+
+        qDebug() << "baudrate" << high_baud_list[high_index] << "not confirmed";
+        set_baud(sync_baud);
+        wait_baud_revert();
+        break;
+
+    case STEP_BAUD_WAIT:
+        /* 等待期间收到的数据均为旧波特率下的乱码, 重新计时 */
+        if(result != REPLY_TIMEOUT)
+        {
+            timeout_timer->start(cur_timeout);
+            break;
+        }
+
+        start_step(STEP_BAUD_REVERT, PROTO_GET_SYNC, 50);
+        break;
+
+    case STEP_BAUD_REVERT:
+        if(result == REPLY_OK)
+        {
+            high_index++;
+            next_baud();
+            break;
+        }
+
+        serial->close();
+        finish_op(false, "波特率切换失败");
+        break;
+
+    case STEP_QUERY:
+        /* 应答在 on_ready_read 中由 process_query 处理, 此处只处理超时: 跳过该项, 重新发出剩余的查询 */
+        emit warning(reply_text(result));
+
+        if(++query_index >= QUERY_NUM)
+        {
+            query_done();
+            break;
+        }
+
+        send_queries();
+        break;
+
+    case STEP_ERASE:
+        if(result != REPLY_OK)
+        {
+            finish_op(false, reply_text(result));
+            break;
+        }
+
+        qDebug() << "erase ok. t = " << step_time.elapsed();
+        emit progress(tick_max, tick_max);
+        resume_pos = 0;
+
+        if(op == OP_ERASE)
+            finish_op(true, "");
+        else if(!segments.isEmpty())
+            start_segment();
+        else
+            start_program();
+        break;
+
+    case STEP_RANGE_CRC:
+        /* 旧版 bootloader 不支持扇区指令, 改为整片擦除烧写 */
+        if((result == REPLY_INVALID) && (sector_index == 0))
+        {
+            qDebug() << "sector commands not supported, full program";
+            start_full_erase();
+            break;
+        }
+
+        if(result != REPLY_OK)
+        {
+            finish_op(false, reply_text(result));
+            break;
+        }
+
+        {
+            uint crc;
+
+            crc = data[0] & 0xff;
+            crc += (data[1] & 0xff) * 256;
+            crc += (data[2] & 0xff) * 65536;
+            crc += (data[3] & 0xff) * 16777216;
+
+            if(crc != sector_crc(fw_sectors.at(sector_index)))
+                dirty.append(sector_index);
+        }
+
+        if(++sector_index < fw_sectors.size())
+        {
+            send_range_crc();
+            break;
+        }
+
+        qDebug() << "dirty sectors" << dirty.size() << "/" << fw_sectors.size();
+        dirty_index = 0;
+
+        if(dirty.isEmpty())
+            start_final_crc();
+        else
+            erase_dirty();
+        break;
+
+    case STEP_SECTOR_ERASE:
+        if(result != REPLY_OK)
+        {
+            finish_op(false, reply_text(result));
+            break;
+        }
+
+        {
+            const FlashSector &sec = fw_sectors.at(dirty.at(dirty_index));
+
+            /* 扇区在固件之外或固件在该扇区内全为 0xFF, 擦除即可 */
+            if(prog_end == prog_base)
+            {
+                if(++dirty_index < dirty.size())
+                    erase_dirty();
+                else
+                    start_final_crc();
+                break;
+            }
+
+            uint param = sec.address;
+            start_param_step(STEP_SET_ADDR, PROTO_SET_PROG_ADDR, &param, 1, 50);
+        }
+        break;
+
+    case STEP_SET_ADDR:
+        if((result == REPLY_INVALID) && full_program)
+        {
+            finish_op(false, "bootloader 不支持设置烧写地址, 请使用bin文件");
+            break;
+        }
+
+        if(result != REPLY_OK)
+        {
+            finish_op(false, reply_text(result));
+            break;
+        }
+
+        start_program();
+        break;
+
+    case STEP_SKIP_PROBE:
+        /* 旧版 bootloader 不支持跳过指令, 空白帧照常发送 */
+        if((result != REPLY_OK) && (result != REPLY_INVALID))
+        {
+            finish_op(false, reply_text(result));
+            break;
+        }
+
+        skip_support = (result == REPLY_OK) ? 1 : 0;
+        qDebug() << "skip blank frames" << skip_support;
+        start_program();
+        break;
+
+    case STEP_PROGRAM:
+        /* 烧写应答由 process_ack 处理, 此处仅会收到超时 */
+        finish_op(false, reply_text(result));
+        break;
+
+    case STEP_CRC:
+        if(result == REPLY_OK)
+        {
+            uint crc;
+
+            crc = data[0] & 0xff;
+            crc += (data[1] & 0xff) * 256;
+            crc += (data[2] & 0xff) * 65536;
+            crc += (data[3] & 0xff) * 16777216;
+
+            emit progress(tick_max, tick_max);
+
+            if(crc == crc_expect)
+            {
+                qDebug() << "crc right";
+                finish_op(true, "");
+            }
+            else
+            {
+                resume_pos = -1;
+                finish_op(false, "校验失败");
+            }
+            break;
+        }
+
+        finish_op(false, reply_text(result));
+        break;
+
+    case STEP_RESUME_POS:
+        if(result == REPLY_TIMEOUT)
+        {
+            finish_op(false, reply_text(result));
+            break;
+        }
+
+        /* 不支持读取编程指针时从断点继续 */
+        if((result == REPLY_OK) && (data.size() >= 4))
+        {
+            long pos = image_pos(read_u32(data, 0));
+
+            if((pos > resume_pos) && (segment_of(pos - 1) == segment_of(resume_pos)))
+            {
+                qDebug() << "device pointer ahead of checkpoint" << pos;
+                resume_pos = pos;
+            }
+        }
+
+        {
+            uint param[2] = {0, (uint)dev_offset(resume_pos)};
+            start_param_step(STEP_RESUME_CRC, PROTO_GET_RANGE_CRC, param, 2, MAX_CRC_TIME * 10);
+        }
+        break;
+
+    case STEP_RESUME_CRC:
+        if(result == REPLY_TIMEOUT)
+        {
+            finish_op(false, reply_text(result));
+            break;
+        }
+
+        /* 不支持扇区指令或已烧写的部分与固件不一致, 整片擦除 */
+        if((result != REPLY_OK) || (read_u32(data, 0) != prefix_crc(dev_offset(resume_pos))))
+        {
+            qDebug() << "checkpoint not confirmed, full program";
+            start_full_erase();
+            break;
+        }
+
+        {
+            uint param[2] = {(uint)dev_offset(resume_pos), (uint)(fw_size - dev_offset(resume_pos))};
+            start_param_step(STEP_RESUME_BLANK, PROTO_GET_RANGE_CRC, param, 2, MAX_CRC_TIME * 10);
+        }
+        break;
+
+    case STEP_RESUME_BLANK:
+        if(result == REPLY_TIMEOUT)
+        {
+            finish_op(false, reply_text(result));
+            break;
+        }
+
+        /* 断点之后已被写入, 继续烧写会覆盖已编程的字 */
+        if((result != REPLY_OK) || (read_u32(data, 0) != crc32_fill(0xff, fw_size - dev_offset(resume_pos), 0)))
+        {
+            qDebug() << "flash after checkpoint not blank, full program";
+            start_full_erase();
+            break;
+        }
+
+        if(resume_pos >= image.size())
+        {
+            start_step(STEP_CRC, PROTO_GET_CRC, MAX_CRC_TIME * 10);
+            break;
+        }
+
+        segment_index = segment_of(resume_pos);
+        set_prog_range(resume_pos, segments.isEmpty() ? image.size() : segments.at(segment_index).end);
+
+        {
+            uint param = dev_offset(resume_pos);
+            start_param_step(STEP_RESUME_ADDR, PROTO_SET_PROG_ADDR, &param, 1, 50);
+        }
+        break;
+
+    case STEP_RESUME_ADDR:
+        if(result == REPLY_INVALID)
+        {
+            start_full_erase();
+            break;
+        }
+
+        if(result != REPLY_OK)
+        {
+            finish_op(false, reply_text(result));
+            break;
+        }
+
+        start_program();
+        break;
+
+    case STEP_BOOT:
+        if(result == REPLY_OK)
+        {
+            serial->close();
+            finish_op(true, "");
+            emit device_closed();
+            break;
+        }
+
+        finish_op(false, reply_text(result));
+        break;
+
+    default:
+        break;
+    }
+}
+
+QString FlashEngine::reply_text(int result)
+{
+    switch (result) {
+    case REPLY_TIMEOUT:
+        return "操作超时";
+    case REPLY_INVALID:
+        return "指令无效";
+    case REPLY_FAILED:
+        return "操作失败";
+    default:
+        return "";
+    }
+}
@@ -0,0 +1,277 @@
+#ifndef FLASHENGINE_H
+#define FLASHENGINE_H
+
+#include <QObject>
+#include <QtSerialPort>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "replyparser.h"
+#include "crc32.h"
+#include "flashlayout.h"
+#include "linktimer.h"
+#include "firmwareimage.h"
+#include "sparseimage.h"
+#include "framepacker.h"
+#include "tracebuffer.h"
+#include "frameencoder.h"
+
+#define BaudRate_Num                7
+#define HighBaud_Num                7
+#define MAX_BAUD_DEFAULT            921600          /*!< 默认协商的最高波特率 */
+#define PROG_WINDOW_DEFAULT         4               /*!< 默认烧写滑动窗口大小, 即最多未确认帧数 */
+#define PROG_WINDOW_MAX             32              /*!< 烧写滑动窗口上限 */
+
+/**
+ * @brief 设备信息, 连接时一次读取. 设备不支持的项为空
+ */
+struct DeviceInfo
+{
+    QByteArray udid;
+    uint fw_size;           /*!< 固件区大小, 单位 byte */
+    QByteArray bl_rev;
+    QByteArray id;
+    QByteArray sn;
+    QByteArray rev;
+    QByteArray des;
+    QByteArray flash_strc;
+    FlashLayout layout;     /*!< 由 flash_strc 解析得到的全部扇区 */
+    uint caps;              /*!< 扩展功能, PROTO_CAP_* 的组合 */
+    uint lz_block;          /*!< 解压缓冲区大小, 单位 byte */
+    uint frame_max;         /*!< 烧写指令的最大数据长度, 为 0 时不支持查询 */
+
+    DeviceInfo() : fw_size(0), caps(0), lz_block(0), frame_max(0) {}
+};
+
+Q_DECLARE_METATYPE(DeviceInfo)
+
+/**
+ * @brief 烧写引擎
+ * @note  运行于独立线程, 独占串口. 所有操作均由 readyRead / bytesWritten / 定时器驱动,
+ *        不阻塞事件循环. 界面通过排队连接调用槽函数, 并通过信号获取进度与结果
+ */
+class FlashEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 引擎操作
+     */
+    enum Operation
+    {
+        OP_NONE = 0,
+        OP_CONNECT,         /*!< 连接设备并读取设备信息 */
+        OP_ERASE,           /*!< 擦除APP */
+        OP_PROGRAM,         /*!< 擦除, 烧写并校验固件 */
+        OP_UPDATE,          /*!< 增量烧写, 只更新不一致的扇区 */
+        OP_VERIFY,          /*!< 仅校验固件 */
+        OP_BOOT             /*!< 引导APP */
+    };
+
+    /**
+     * @brief 统计耗时的阶段
+     */
+    enum Phase
+    {
+        PHASE_SYNC = 0,     /*!< 探测波特率与同步 */
+        PHASE_BAUD,         /*!< 切换波特率 */
+        PHASE_QUERY,        /*!< 读取设备信息 */
+        PHASE_ERASE,        /*!< 整片或扇区擦除 */
+        PHASE_PROGRAM,      /*!< 烧写 */
+        PHASE_CRC,          /*!< 整个固件区或扇区CRC */
+        PHASE_BOOT,         /*!< 引导 */
+        PHASE_NUM
+    };
+
+    /**
+     * @brief 一次操作的统计, 每次操作开始时清零, 供性能测试使用
+     */
+    struct Stats
+    {
+        qint64 phase_ns[PHASE_NUM];         /*!< 各阶段耗时, 单位 ns */
+        long frames;                        /*!< 烧写指令数 */
+        long data_bytes;                    /*!< 烧写的固件长度, 含跳过的部分 */
+        long wire_bytes;                    /*!< 烧写指令写入串口的字节数 */
+        QVector<int> ack_us;                /*!< 每条烧写指令从发送到确认的时间, 单位 us */
+    };
+
+    explicit FlashEngine(QObject *parent = 0);
+    ~FlashEngine();
+
+    const Stats &stats(void) const { return op_stats; }
+    static const char *phase_name(int phase);
+
+public slots:
+    void open_device(QString port_name, int baudrate);
+    void close_device(void);
+    void erase(void);
+    void program(QByteArray data);
+    void program_file(QString path);
+    void program_image(FirmwareImage image);
+    void update(QByteArray data);
+    void update_file(QString path);
+    void verify(QByteArray data);
+    void boot(void);
+    void set_prog_window(int window);
+    void set_max_baudrate(int baudrate);
+    void set_skip_blank(bool enable);
+    void set_compress(bool enable);
+    void set_max_frame(int bytes);
+    void set_resume(bool enable);
+    void set_trace(bool enable);
+    void save_trace(QString path);
+
+signals:
+    void device_ready(DeviceInfo info);                     /*!< 设备信息读取完成 */
+    void device_closed(void);                               /*!< 串口已关闭 */
+    void progress(int value, int max);                      /*!< 当前操作进度 */
+    void warning(QString msg);                              /*!< 非致命错误 */
+    void finished(int op, bool ok, QString msg);            /*!< 操作结束 */
+
+private slots:
+    void on_ready_read(void);
+    void on_bytes_written(qint64 bytes);
+    void on_timeout(void);
+    void on_tick(void);
+    void on_pack_ready(void);
+
+private:
+    enum Step
+    {
+        STEP_IDLE = 0,
+        STEP_DETECT,        /*!< 探测波特率 */
+        STEP_SYNC,          /*!< 同步设备 */
+        STEP_SET_BAUD,      /*!< 请求设备切换波特率 */
+        STEP_BAUD_CONFIRM,  /*!< 在新波特率下确认同步 */
+        STEP_BAUD_WAIT,     /*!< 切换失败, 等待设备恢复原波特率 */
+        STEP_BAUD_REVERT,   /*!< 在原波特率下重新同步 */
+        STEP_QUERY,         /*!< 依次读取设备信息 */
+        STEP_ERASE,         /*!< 等待擦除完成 */
+        STEP_PROGRAM,       /*!< 滑动窗口烧写 */
+        STEP_CRC,           /*!< 等待CRC校验结果 */
+        STEP_RANGE_CRC,     /*!< 读取扇区CRC */
+        STEP_SECTOR_ERASE,  /*!< 擦除扇区 */
+        STEP_SET_ADDR,      /*!< 设置编程指针 */
+        STEP_SKIP_PROBE,    /*!< 检查设备是否支持跳过指令 */
+        STEP_BOOT,          /*!< 等待引导应答 */
+        STEP_RESUME_POS,    /*!< 从断点继续: 读取编程指针 */
+        STEP_RESUME_CRC,    /*!< 从断点继续: 校验已烧写的部分 */
+        STEP_RESUME_BLANK,  /*!< 从断点继续: 确认断点之后仍为擦除状态 */
+        STEP_RESUME_ADDR    /*!< 从断点继续: 设置编程指针 */
+    };
+
+    QSerialPort *serial;
+    QTimer *timeout_timer;                  /*!< 应答超时定时器 */
+    QTimer *tick_timer;                     /*!< 擦除/校验进度刷新定时器 */
+    QElapsedTimer step_time;                /*!< 当前步骤已用时间 */
+    int baudrate_list[BaudRate_Num];
+    int high_baud_list[HighBaud_Num];       /*!< 同步后可协商的波特率, 从高到低 */
+
+    int op;
+    int step;
+    qint64 step_start;                      /*!< 进入当前步骤的时刻, 单位 ns */
+    Stats op_stats;
+    int cur_timeout;                        /*!< 当前等待的超时时间, 单位 ms */
+    int wait_cmd;                           /*!< 当前等待应答的指令 */
+    QElapsedTimer wait_time;                /*!< 指令发送完成后的等待时间 */
+    QElapsedTimer link_clock;               /*!< 烧写帧发送时刻的时钟 */
+    QVector<qint64> frame_time;             /*!< 未确认烧写帧的发送时刻, 单位 us */
+    QVector<int> frame_len;                 /*!< 未确认烧写帧覆盖的固件长度 */
+    QVector<int> frame_cmd;                 /*!< 未确认烧写帧的指令 */
+    LinkTimer link;                         /*!< 各指令的应答时间统计 */
+    int tick_max;                           /*!< 进度条最大值, 单位 10ms */
+    ReplyParser parser;
+    FrameEncoder tx;                        /*!< 发送缓存 */
+    TraceBuffer trace;                      /*!< 指令收发跟踪, 默认不启用 */
+
+    QVector<int> detect_list;               /*!< 自动探测的波特率顺序 */
+    int detect_fallback;                    /*!< detect_list 中协商波特率 (设备未复位时可能停留) 的起始位置 */
+    bool sync_cached;                       /*!< sync_baud 为设备复位后的同步波特率, 可以记录到缓存 */
+    int baud_index;
+    int max_baudrate;                       /*!< 协商的最高波特率, 为 0 时不协商 */
+    int sync_baud;                          /*!< 同步成功时的波特率 */
+    int high_index;
+    int confirm_count;
+    int query_index;
+    long fw_size;
+    DeviceInfo info;
+    FlashLayout fw_sectors;                 /*!< 固件区扇区, 地址为相对固件区的偏移 */
+
+    int prog_window;
+    FirmwareImage image;
+    bool full_program;                      /*!< 整片烧写或增量烧写 */
+    long prog_base;                         /*!< 本次烧写的起始偏移 */
+    long prog_end;                          /*!< 本次烧写的结束偏移 */
+    long sent;                              /*!< 已发出的固件长度, 含跳过的部分 */
+    long acked;
+    long msg_sent;                          /*!< 已发出的烧写指令数 */
+    long msg_acked;
+    bool skip_blank;                        /*!< 是否跳过全为 0xFF 的帧 */
+    int skip_support;                       /*!< 设备是否支持跳过指令, -1 为未知 */
+    bool compress;                          /*!< 设备支持时是否发送压缩帧 */
+    bool use_lz;                            /*!< 本次烧写范围使用压缩帧 */
+    int max_frame;                          /*!< 主机限制的最大数据帧长度, 为 0 时不限制 */
+    int frame_data;                         /*!< 本次烧写范围的数据帧长度 */
+    bool resume;                            /*!< 整片烧写中断后是否从断点继续 */
+    bool resume_track;                      /*!< 整片烧写是否记录断点 */
+    QByteArray image_digest;                /*!< 整片烧写的固件摘要, 有断点或中断时才计算 */
+    long resume_pos;                        /*!< 整片烧写已确认的 image 位置, 为 -1 时尚未擦除或设备内容未知 */
+    FramePacker *packer;
+    uint crc_expect;                        /*!< 期望的固件区CRC */
+    QVector<int> dirty;                     /*!< 需要更新的扇区 */
+    int sector_index;
+    int dirty_index;
+
+    /**
+     * @brief 带地址固件的一段, 数据在 image 中连续存放
+     */
+    struct ProgSegment
+    {
+        uint offset;                        /*!< 在固件区内的偏移 */
+        long base;                          /*!< 在 image 中的起始位置 */
+        long end;                           /*!< 在 image 中的结束位置 */
+    };
+    QVector<ProgSegment> segments;          /*!< 整片烧写时只发送这些段, 为空时烧写整个 image */
+    int segment_index;
+
+    void start_op(int operation);
+    void set_step(int s);
+    void finish_op(bool ok, QString msg);
+    void start_step(int s, int cmd, int timeout);
+    void send_normal_cmd(int cmd, int timeout);
+    void start_wait(int cmd, int def);
+    void start_param_step(int s, int cmd, const uint *param, int num, int timeout);
+    bool check_image(int operation, qint64 filelen);
+    bool load_sparse(int operation, const QString &path);
+    void start_segment(void);
+    uint image_crc(void);
+    uint prefix_crc(long end);
+    int segment_of(long pos) const;
+    long dev_offset(long pos) const;
+    long image_pos(long offset) const;
+    QByteArray make_digest(void);
+    bool start_resume(void);
+    void begin_program(int operation);
+    void start_full_erase(void);
+    void set_prog_range(long base, long end);
+    void send_range_crc(void);
+    void erase_dirty(void);
+    uint sector_crc(const FlashSector &sec);
+    void start_final_crc(void);
+    void send_frames(void);
+    bool set_baud(int baudrate);
+    bool parse_replies(const char *p, qint64 len);
+    void handle_reply(int result, QByteArray data);
+    bool process_ack(int result);
+    int prog_ack_timeout(void) const;
+    void next_baud(void);
+    void wait_baud_revert(void);
+    void send_queries(void);
+    bool process_query(int result, QByteArray data);
+    void query_done(void);
+    void start_program(void);
+    void program_done(void);
+    static QString reply_text(int result);
+};
+
+#endif // FLASHENGINE_H
@@ -0,0 +1,237 @@
+#include "flashlayout.h"
+#include <algorithm>
+
+#define FLASH_STORAGE_MAX           255             /*!< 存储器数量上限, 受 FlashSector::storage 宽度限制 */
+#define FLASH_SECTOR_MAX            1024            /*!< 扇区总数上限, 超出时视为应答损坏 */
+#define FLASH_ADDR_END              0x100000000ULL  /*!< 扇区不能超出 32 位地址空间 */
+
+FlashLayout::FlashLayout()
+{
+}
+
+/**
+* @brief  读取一个无符号数
+* @param  [in] p const char*. 当前位置
+* @param  [in] end const char*. 结束位置
+* @param  [in] base uint. 进制, 10 或 16
+* @param  [out] value uint*. 读取到的数
+* @return 数字之后的位置, 没有数字或超出 32 位时返回 NULL
+*/
+static const char *read_number(const char *p, const char *end, uint base, uint *value)
+{
+    const char *start = p;
+    quint64 v = 0;
+
+    while(p < end)
+    {
+        uint d;
+        char c = *p;
+
+        if((c >= '0') && (c <= '9'))
+            d = c - '0';
+        else if((base == 16) && ((c | 0x20) >= 'a') && ((c | 0x20) <= 'f'))
+            d = (c | 0x20) - 'a' + 10;
+        else
+            break;
+
+        v = v * base + d;
+        if(v > 0xffffffffULL)
+            return NULL;
+        p++;
+    }
+
+    *value = (uint)v;
+    return (p == start) ? NULL : p;
+}
+
+/**
+* @brief  解析 FLASH 结构描述, 只扫描一遍, 不使用正则表达式
+* @param  [in] text QByteArray. 设备返回的 FLASH 结构描述
+* @return 是否解析成功. 失败时布局为空
+*/
+bool FlashLayout::parse(const QByteArray &text)
+{
+    const char *p = text.constData();
+    const char *end = p + text.size();
+
+    clear();
+
+    while((p < end) && (*p != '@'))
+        p++;
+
+    while((p < end) && (names.size() < FLASH_STORAGE_MAX))
+    {
+        p = parse_storage(p + 1, end);
+        if(p == NULL)
+        {
+            clear();
+            return false;
+        }
+
+        // 跳过存储器描述的剩余部分
+        while((p < end) && (*p != '@'))
+            p++;
+    }
+
+    return !sectors.isEmpty();
+}
+
+/**
+* @brief  解析一个存储器的描述, 即 '@' 之后的 位置/0x起始地址/扇区组...
+* @note   扇区数量与大小来自设备, 总数超过 FLASH_SECTOR_MAX 或超出 32 位地址空间时视为格式错误,
+*         避免损坏的应答导致巨大的分配或地址回绕
+* @param  [in] p const char*. '@' 之后的位置
+* @param  [in] end const char*. 结束位置
+* @return 最后一个扇区组之后的位置, 格式错误时返回 NULL
+*/
+const char *FlashLayout::parse_storage(const char *p, const char *end)
+{
+    const char *name = p;
+    uint start;
+
+    // 储存器位置
+    while((p < end) && (*p != '/'))
+        p++;
+    if(p == end)
+        return NULL;
+    names.append(QByteArray(name, p - name).trimmed());
+    p++;
+
+    // 储存器起始地址
+    if((end - p < 2) || (p[0] != '0') || ((p[1] | 0x20) != 'x'))
+        return NULL;
+    p = read_number(p + 2, end, 16, &start);
+    if((p == NULL) || (p == end) || (*p != '/'))
+        return NULL;
+    p++;
+
+    quint64 addr = start;
+
+    // 扇区组: 数量*大小单位权限, 以 ',' 分隔
+    for(;;)
+    {
+        uint count, size;
+        quint64 bytes;
+        unsigned char perm;
+
+        p = read_number(p, end, 10, &count);
+        if((p == NULL) || (p == end) || (*p != '*'))
+            return NULL;
+
+        p = read_number(p + 1, end, 10, &size);
+        if((p == NULL) || (p == end))
+            return NULL;
+
+        bytes = size;
+        if(*p == 'K')
+        {
+            bytes *= 1024;
+            p++;
+        }
+        else if(*p == 'M')
+        {
+            bytes *= 1024 * 1024;
+            p++;
+        }
+        else if((*p == ' ') || (*p == 'B'))
+        {
+            p++;
+        }
+
+        if((p == end) || (*p < 'a') || (*p > 'g'))
+            return NULL;
+        perm = *p - 'a' + 1;
+        p++;
+
+        if((count > (uint)(FLASH_SECTOR_MAX - sectors.size())) || (bytes == 0) || (bytes >= FLASH_ADDR_END)
+                || (addr + count * bytes > FLASH_ADDR_END))
+            return NULL;
+
+        sectors.reserve(sectors.size() + count);
+        for(uint k = 0; k < count; k++)
+        {
+            FlashSector s;
+            s.address = (uint)addr;
+            s.size = (uint)bytes;
+            s.perm = perm;
+            s.storage = names.size() - 1;
+            sectors.append(s);
+
+            addr += bytes;
+        }
+
+        if((p == end) || (*p != ','))
+            return p;
+        p++;
+    }
+}
+
+void FlashLayout::clear(void)
+{
+    sectors.clear();
+    names.clear();
+}
+
+/**
+* @brief  计算固件区的起始地址
+* @note   固件区位于第一个存储器的末尾 fw_size 字节 (bootloader 位于其开头)
+* @param  [in] fw_size uint. 固件区大小
+* @param  [out] start uint*. 固件区起始地址
+* @return 布局为空或第一个存储器小于固件区时返回 false
+*/
+bool FlashLayout::fw_start(uint fw_size, uint *start) const
+{
+    int last = 0;
+
+    // 第一个存储器的扇区位于表头
+    while((last < sectors.size()) && (sectors.at(last).storage == 0))
+        last++;
+
+    if((fw_size == 0) || (last == 0))
+        return false;
+
+    /* 存储器可以一直延伸到 32 位地址空间末尾, 按 64 位计算避免回绕 */
+    const FlashSector &tail = sectors.at(last - 1);
+    quint64 end = (quint64)tail.address + tail.size;
+    if(end - sectors.at(0).address < fw_size)
+        return false;
+
+    *start = (uint)(end - fw_size);
+    return true;
+}
+
+/**
+* @brief  取出固件区内的扇区
+* @note   固件区位于第一个存储器的末尾 fw_size 字节 (bootloader 位于其开头)
+* @param  [in] fw_size uint. 固件区大小
+* @return 固件区布局, address 为相对固件区起始位置的偏移. 固件区起始位置不在扇区边界上时返回空
+*/
+FlashLayout FlashLayout::fw_area(uint fw_size) const
+{
+    FlashLayout area;
+    int last = 0;
+    uint start;
+
+    if(!fw_start(fw_size, &start))
+        return area;
+
+    while((last < sectors.size()) && (sectors.at(last).storage == 0))
+        last++;
+
+    const FlashSector *first = std::lower_bound(sectors.constData(), sectors.constData() + last, start,
+                                                [](const FlashSector &s, uint a) { return s.address < a; });
+
+    if((first == sectors.constData() + last) || (first->address != start))
+        return area;
+
+    area.names.append(names.at(0));
+    area.sectors.reserve(sectors.constData() + last - first);
+    for(const FlashSector *s = first; s < sectors.constData() + last; s++)
+    {
+        FlashSector tmp = *s;
+        tmp.address -= start;
+        area.sectors.append(tmp);
+    }
+
+    return area;
+}
@@ -0,0 +1,56 @@
+#ifndef FLASHLAYOUT_H
+#define FLASHLAYOUT_H
+
+#include <QByteArray>
+#include <QVector>
+
+/**
+ * @brief 扇区权限, 即 FLASH 结构描述中权限字母 ('a' ~ 'g') 减去 'a' - 1
+ */
+#define FLASH_PERM_READ             0x01            /*!< 可读 */
+#define FLASH_PERM_ERASE            0x02            /*!< 可擦除 */
+#define FLASH_PERM_WRITE            0x04            /*!< 可写 */
+
+/**
+ * @brief 扇区
+ */
+struct FlashSector
+{
+    uint address;           /*!< 起始地址 */
+    uint size;              /*!< 大小, 单位 byte */
+    unsigned char perm;     /*!< 权限, FLASH_PERM_* 的组合 */
+    unsigned char storage;  /*!< 所属存储器序号 */
+};
+
+/**
+ * @brief FLASH 布局, 按地址顺序连续存放的扇区表
+ * @note  由设备返回的 FLASH 结构描述一次扫描解析得到, 格式为
+ *        @位置/0x起始地址/数量*大小单位权限,数量*大小单位权限...
+ *        单位为 K, M 或空格 (byte), 可以有多个存储器
+ */
+class FlashLayout
+{
+public:
+    FlashLayout();
+
+    bool parse(const QByteArray &text);
+    void clear(void);
+
+    int size(void) const { return sectors.size(); }
+    bool isEmpty(void) const { return sectors.isEmpty(); }
+    const FlashSector &at(int i) const { return sectors.at(i); }
+
+    int storage_count(void) const { return names.size(); }
+    QByteArray storage_name(int storage) const { return names.at(storage); }
+
+    bool fw_start(uint fw_size, uint *start) const;
+    FlashLayout fw_area(uint fw_size) const;
+
+private:
+    QVector<FlashSector> sectors;
+    QVector<QByteArray> names;              /*!< 存储器名称 */
+
+    const char *parse_storage(const char *p, const char *end);
+};
+
+#endif // FLASHLAYOUT_H
@@ -0,0 +1,124 @@
+#ifndef FRAMEENCODER_H
+#define FRAMEENCODER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <string.h>
+#include "protocol.h"
+
+#define FRAME_ENCODER_SIZE          (16 * 1024)     /*!< 发送缓存大小, 可容纳一个完整烧写窗口的普通帧或至少一个最长的长帧 */
+#define FRAME_HEAD                  2               /*!< 指令 + 数据长度 */
+#define FRAME_EXT_HEAD              3               /*!< 长帧: 指令 + 数据长度(2) */
+#define FRAME_EOC                   1
+
+/**
+ * @brief 指令组帧
+ * @note  缓存在构造时一次分配, 之后在各帧, 各次操作之间重复使用. 多条指令连续组帧后一次写入串口,
+ *        数据整段复制. 串口写入时即复制数据, 写入后缓存可立即重用
+ */
+class FrameEncoder
+{
+public:
+    FrameEncoder() : buf(FRAME_ENCODER_SIZE, 0), len(0) {}
+
+    void clear(void) { len = 0; }
+    const char *data(void) const { return buf.constData(); }
+    int size(void) const { return len; }
+
+    /**
+     * @brief 是否还能放下编码后长度为 frame_size 的一帧
+     */
+    bool fits(int frame_size) const { return len + frame_size <= buf.size(); }
+
+    /** @brief put_data 的帧长度 */
+    static int data_size(int count) { return FRAME_HEAD + count + FRAME_EOC; }
+    /** @brief put_data_ext 的帧长度 */
+    static int ext_size(int count) { return FRAME_EXT_HEAD + count + FRAME_EOC; }
+    /** @brief put_param 的帧长度 */
+    static int param_size(int num) { return FRAME_HEAD + num * 4 + FRAME_EOC; }
+
+    /**
+    * @brief  无参数指令, 格式为 指令 + EOC
+    * @return 帧长度
+    */
+    int put_cmd(int cmd)
+    {
+        char *p = buf.data() + len;
+
+        p[0] = (char)cmd;
+        p[1] = (char)PROTO_EOC;
+        len += 2;
+        return 2;
+    }
+
+    /**
+    * @brief  带数据的指令, 格式为 指令 + 数据长度 + 数据 + EOC
+    * @return 帧长度
+    */
+    int put_data(int cmd, const char *data, int count)
+    {
+        char *p = buf.data() + len;
+
+        p[0] = (char)cmd;
+        p[1] = (char)count;
+        memcpy(p + 2, data, count);
+        p[count + 2] = (char)PROTO_EOC;
+        len += data_size(count);
+        return data_size(count);
+    }
+
+    /**
+    * @brief  长帧, 格式为 指令 + 数据长度(2) + 数据 + EOC
+    * @return 帧长度
+    */
+    int put_data_ext(int cmd, const char *data, int count)
+    {
+        char *p = buf.data() + len;
+
+        p[0] = (char)cmd;
+        p[1] = (char)(count & 0xff);
+        p[2] = (char)((count >> 8) & 0xff);
+        memcpy(p + 3, data, count);
+        p[count + 3] = (char)PROTO_EOC;
+        len += ext_size(count);
+        return ext_size(count);
+    }
+
+    /**
+    * @brief  带参数的指令, 参数以小端序发送
+    * @return 帧长度
+    */
+    int put_param(int cmd, const uint *param, int num)
+    {
+        char *p = buf.data() + len;
+
+        p[0] = (char)cmd;
+        p[1] = (char)(num * 4);
+        for(int i = 0; i < num; i++)
+        {
+            p[2 + i * 4] = (char)(param[i] & 0xff);
+            p[3 + i * 4] = (char)((param[i] >> 8) & 0xff);
+            p[4 + i * 4] = (char)((param[i] >> 16) & 0xff);
+            p[5 + i * 4] = (char)((param[i] >> 24) & 0xff);
+        }
+        p[num * 4 + 2] = (char)PROTO_EOC;
+        len += param_size(num);
+        return param_size(num);
+    }
+
+    /**
+     * @brief 写入串口并清空
+     */
+    void flush(QIODevice *dev)
+    {
+        if(len > 0)
+            dev->write(buf.constData(), len);
+        len = 0;
+    }
+
+private:
+    QByteArray buf;
+    int len;
+};
+
+#endif // FRAMEENCODER_H
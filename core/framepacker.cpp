@@ -0,0 +1,236 @@
+#include "framepacker.h"
+#include "lzblock.h"
+#include <string.h>
+
+#define PACK_LZ_HEAD                2               /*!< PROTO_PROG_LZ 参数中原始长度所占字节 */
+#define PACK_LZ_TRIES               6               /*!< 压缩后超出一帧时缩短原始长度重试的次数 */
+
+FramePacker::FramePacker(QObject *parent) :
+    QThread(parent)
+{
+    base = 0;
+    end = 0;
+    skip = false;
+    frame_data = PACK_FRAME_DATA;
+    lz_block = 0;
+    next = 0;
+    waiting = false;
+    stream_used = 0;
+}
+
+FramePacker::~FramePacker()
+{
+    stop();
+}
+
+/**
+ * @brief 开始压缩 [base, end), 之前的任务被丢弃
+ * @param [in] image FirmwareImage. 固件
+ * @param [in] base long. 起始位置
+ * @param [in] end long. 结束位置
+ * @param [in] skip bool. 是否把空白帧合为跳过指令
+ * @param [in] frame_data int. 数据帧长度
+ * @param [in] lz_block int. 设备解压缓冲区大小, 即一帧解压后的最大长度
+ */
+void FramePacker::start_pack(const FirmwareImage &image, long base, long end, bool skip, int frame_data, int lz_block)
+{
+    stop();
+
+    this->image = image;
+    this->base = base;
+    this->end = end;
+    this->skip = skip;
+    this->frame_data = frame_data;
+    this->lz_block = lz_block;
+
+    /*
+     * 按最坏情况一次分配, 压缩期间不再扩大:
+     * 数据帧在空白块处截断时也至少覆盖 min(frame_data, 252) 字节, 压缩帧覆盖的数据多于 frame_data,
+     * 每个压缩帧的参数最长为 252 字节 (原始长度 + 压缩数据)
+    */
+    long min_len = qMin(frame_data, PACK_FRAME_DATA);
+    long lz_frames = (end - base) / (frame_data + 1) + 1;
+    int need = (int)qMax(end - base, lz_frames * PACK_FRAME_DATA) + PACK_FRAME_DATA;
+    if(stream.size() < need)
+        stream.resize(need);
+    if(scratch.size() < lz_scratch_size(lz_block))
+        scratch.resize(lz_scratch_size(lz_block));
+    stream_used = 0;
+
+    frames.resize(0);
+    frames.reserve((int)((end - base) / min_len) + 1);
+    next = 0;
+    waiting = false;
+    cancel.store(0);
+
+    start();
+}
+
+/**
+ * @brief 中止压缩并等待线程退出, 释放对固件的引用
+ */
+void FramePacker::stop(void)
+{
+    cancel.store(1);
+    wait();
+
+    /* 保留容量, 下次烧写重复使用 */
+    frames.resize(0);
+    image = FirmwareImage();
+}
+
+/**
+* @brief  按顺序取出下一帧
+* @param  [out] frame PackedFrame*. 帧
+* @return 尚未压缩完成时返回 false, 之后会发出 ready 信号
+*/
+bool FramePacker::take(PackedFrame *frame)
+{
+    QMutexLocker locker(&lock);
+
+    if(next >= frames.size())
+    {
+        waiting = true;
+        return false;
+    }
+
+    *frame = frames.at(next);
+    next++;
+    return true;
+}
+
+void FramePacker::run(void)
+{
+    long pos = base;
+
+    while((pos < end) && (cancel.load() == 0))
+    {
+        PackedFrame f;
+
+        plan(image, pos, end, skip, frame_data, &f);
+        if((f.cmd != PROTO_PROG_SKIP) && pack_lz(image, pos, end, frame_data, lz_block, scratch.data(), &f))
+        {
+            if(stream_used + f.data_len <= stream.size())
+            {
+                char *p = stream.data() + stream_used;
+
+                memcpy(p, f.data, f.data_len);
+                f.data = p;
+                stream_used += f.data_len;
+            }
+            else
+            {
+                plan(image, pos, end, skip, frame_data, &f);
+            }
+        }
+        pos += f.len;
+
+        lock.lock();
+        frames.append(f);
+        bool notify = waiting;
+        waiting = false;
+        lock.unlock();
+
+        if(notify)
+            emit ready();
+    }
+}
+
+/**
+* @brief  不压缩时的下一帧: 连续的空白块合为一条跳过指令, 否则为一个 frame_data 字节的数据帧
+* @note   空白按 252 字节的块检查, 长帧遇到其后仍有数据的空白块时在此截断.
+*         最后一帧总是数据帧, 范围末尾的 0xFF 应事先去掉, 因此被跳过的块都是完整的
+* @param  [in] image FirmwareImage. 固件
+* @param  [in] pos long. 当前位置
+* @param  [in] end long. 结束位置
+* @param  [in] skip bool. 是否跳过空白块
+* @param  [in] frame_data int. 数据帧长度, 大于 255 时使用长帧
+* @param  [out] frame PackedFrame*. 帧
+*/
+void FramePacker::plan(const FirmwareImage &image, long pos, long end, bool skip, int frame_data, PackedFrame *frame)
+{
+    int count = 0;
+
+    frame->pos = pos;
+    frame->data = NULL;
+    frame->data_len = 0;
+
+    if(skip)
+    {
+        while((pos + (long)(count + 1) * PACK_FRAME_DATA < end) && image.blank(pos + (long)count * PACK_FRAME_DATA, PACK_FRAME_DATA))
+            count++;
+    }
+
+    if(count > 0)
+    {
+        frame->cmd = PROTO_PROG_SKIP;
+        frame->len = count * PACK_FRAME_DATA;
+        return;
+    }
+
+    frame->cmd = (frame_data > 255) ? PROTO_PROG_MULTI_EXT : PROTO_PROG_MULTI;
+    frame->len = (int)qMin((long)frame_data, end - pos);
+
+    if(skip)
+    {
+        for(int off = PACK_FRAME_DATA; off + PACK_FRAME_DATA <= frame->len; off += PACK_FRAME_DATA)
+        {
+            if((pos + off + PACK_FRAME_DATA < end) && image.blank(pos + off, PACK_FRAME_DATA))
+            {
+                frame->len = off;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief pack_lz 所需的压缩缓存大小
+ */
+int FramePacker::lz_scratch_size(int lz_block)
+{
+    return LZ_BOUND(qMin(lz_block, 0xffff)) + PACK_LZ_HEAD;
+}
+
+/**
+* @brief  把从 pos 开始的数据压缩为一帧
+* @note   原始长度最多为设备的解压缓冲区大小; 压缩后超出一帧时按压缩率缩短后重试.
+*         压缩帧覆盖的数据不多于一个数据帧时不使用压缩. 压缩帧的参数长度只有 1 字节, 不使用长帧
+* @param  [in] image FirmwareImage. 固件
+* @param  [in] pos long. 当前位置
+* @param  [in] end long. 结束位置
+* @param  [in] frame_data int. 数据帧长度
+* @param  [in] lz_block int. 设备解压缓冲区大小
+* @param  [out] scratch char*. 压缩缓存, 大小为 lz_scratch_size(lz_block)
+* @param  [out] frame PackedFrame*. 成功时改为压缩帧, 参数指向 scratch
+* @return 是否使用压缩帧
+*/
+bool FramePacker::pack_lz(const FirmwareImage &image, long pos, long end, int frame_data, int lz_block, char *scratch, PackedFrame *frame)
+{
+    const int cap = PACK_FRAME_DATA - PACK_LZ_HEAD;
+    int raw = (int)qMin((long)qMin(lz_block, 0xffff), end - pos) & ~3;
+    int out_size = LZ_BOUND(raw);
+
+    for(int i = 0; (i < PACK_LZ_TRIES) && (raw > frame_data); i++)
+    {
+        int n = lz_compress(image.data() + pos, raw, scratch + PACK_LZ_HEAD, out_size);
+
+        if(n <= cap)
+        {
+            scratch[0] = (char)raw;
+            scratch[1] = (char)(raw >> 8);
+
+            frame->cmd = PROTO_PROG_LZ;
+            frame->len = raw;
+            frame->data = scratch;
+            frame->data_len = n + PACK_LZ_HEAD;
+            return true;
+        }
+
+        /* 按本次的压缩率估计能放进一帧的长度, 每次至少缩短 1/8 */
+        long fit = (long)raw * cap / n;
+        raw = (int)qMin(fit, (long)(raw - raw / 8)) & ~3;
+    }
+
+    return false;
+}
@@ -0,0 +1,73 @@
+#ifndef FRAMEPACKER_H
+#define FRAMEPACKER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QVector>
+#include "firmwareimage.h"
+#include "protocol.h"
+
+#define PACK_FRAME_DATA             ((PROTO_PROG_MULTI_MAX - 1) * 4)    /*!< 普通帧最多 252 字节, 也是空白检查的单位 */
+#define PACK_FRAME_DATA_MAX         8192            /*!< 长帧的数据长度上限 */
+
+/**
+ * @brief 一条烧写指令及其覆盖的固件范围
+ */
+struct PackedFrame
+{
+    int cmd;                /*!< PROTO_PROG_MULTI, PROTO_PROG_MULTI_EXT, PROTO_PROG_SKIP 或 PROTO_PROG_LZ */
+    long pos;               /*!< 在 image 中的位置 */
+    int len;                /*!< 覆盖的原始数据长度 */
+    const char *data;       /*!< PROTO_PROG_LZ 的参数, 在下一次 start_pack 或 stop 之前有效. 其余指令为 NULL */
+    int data_len;           /*!< 参数长度 */
+};
+
+/**
+ * @brief 烧写帧压缩线程
+ * @note  在发送的同时按顺序把烧写范围压缩为独立解码的帧, 发送方用 take 依次取出.
+ *        取不到时发送方等待, 新的帧压缩完成后发出 ready 信号.
+ *        缓存在开始压缩时按范围大小一次分配, 之后各次烧写重复使用
+ */
+class FramePacker : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit FramePacker(QObject *parent = 0);
+    ~FramePacker();
+
+    void start_pack(const FirmwareImage &image, long base, long end, bool skip, int frame_data, int lz_block);
+    void stop(void);
+    bool take(PackedFrame *frame);
+
+    static void plan(const FirmwareImage &image, long pos, long end, bool skip, int frame_data, PackedFrame *frame);
+    static int lz_scratch_size(int lz_block);
+    static bool pack_lz(const FirmwareImage &image, long pos, long end, int frame_data, int lz_block, char *scratch, PackedFrame *frame);
+
+signals:
+    void ready(void);                       /*!< 发送方等待时有新的帧可取 */
+
+protected:
+    void run(void);
+
+private:
+    FirmwareImage image;
+    long base;
+    long end;
+    bool skip;
+    int frame_data;                         /*!< 数据帧长度 */
+    int lz_block;
+
+    QByteArray scratch;                     /*!< 压缩缓存 */
+    QByteArray stream;                      /*!< 压缩帧的参数依次存放于此, 预先分配, 压缩期间不重新分配 */
+    int stream_used;                        /*!< 仅由压缩线程访问 */
+
+    QMutex lock;
+    QVector<PackedFrame> frames;            /*!< 已压缩的帧, 预先分配 */
+    int next;                               /*!< 下一个取出的帧 */
+    bool waiting;                           /*!< 发送方正在等待 */
+    QAtomicInt cancel;
+};
+
+#endif // FRAMEPACKER_H
@@ -0,0 +1,80 @@
+#include "linktimer.h"
+
+LinkTimer::LinkTimer()
+{
+    reset();
+}
+
+void LinkTimer::reset(void)
+{
+    for(int i = 0; i < 256; i++)
+    {
+        stat[i].srtt = 0;
+        stat[i].rttvar = 0;
+        stat[i].samples = 0;
+    }
+}
+
+/**
+ * @brief 记录一次应答时间
+ * @param [in] cmd int. 指令
+ * @param [in] us qint64. 从发送完成到收到应答的时间, 单位 us
+ */
+void LinkTimer::sample(int cmd, qint64 us)
+{
+    Stat &s = stat[cmd & 0xff];
+
+    if(us < 0)
+        return;
+
+    if(s.samples == 0)
+    {
+        s.srtt = us;
+        s.rttvar = us / 2;
+    }
+    else
+    {
+        qint64 err = s.srtt - us;
+        if(err < 0)
+            err = -err;
+
+        s.rttvar = (3 * s.rttvar + err) / 4;
+        s.srtt = (7 * s.srtt + us) / 8;
+    }
+
+    s.samples++;
+}
+
+/**
+* @brief  应答超时时间
+* @param  [in] cmd int. 指令
+* @param  [in] def int. 尚无样本时的超时时间, 单位 ms
+* @return 超时时间, 单位 ms
+*/
+int LinkTimer::timeout(int cmd, int def) const
+{
+    const Stat &s = stat[cmd & 0xff];
+
+    if(s.samples == 0)
+        return def;
+
+    qint64 rto = (s.srtt + 4 * s.rttvar + 999) / 1000;
+
+    return (int)qBound((qint64)LINK_RTO_MIN, rto, (qint64)LINK_RTO_MAX);
+}
+
+/**
+* @brief  预计应答时间, 用于显示进度
+* @param  [in] cmd int. 指令
+* @param  [in] def int. 尚无样本时的预计时间, 单位 ms
+* @return 预计时间, 单位 ms
+*/
+int LinkTimer::estimate(int cmd, int def) const
+{
+    const Stat &s = stat[cmd & 0xff];
+
+    if(s.samples == 0)
+        return def;
+
+    return (int)((s.srtt + 999) / 1000);
+}
@@ -0,0 +1,39 @@
+#ifndef LINKTIMER_H
+#define LINKTIMER_H
+
+#include <QtGlobal>
+
+#define LINK_RTO_MIN                10              /*!< 超时时间下限, 单位 ms, 覆盖系统定时器与 USB 串口的延迟抖动 */
+#define LINK_RTO_MAX                60000           /*!< 超时时间上限, 单位 ms */
+
+/**
+ * @brief 链路计时
+ * @note  按指令统计从发送完成到收到应答的时间, 即链路往返时间与设备处理时间之和.
+ *        采用 TCP 重传超时 (RFC 6298) 的平滑均值与平均偏差估计:
+ *        SRTT = 7/8 SRTT + 1/8 R, RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, RTO = SRTT + 4 RTTVAR.
+ *        指令尚无样本时使用调用者给出的默认值
+ */
+class LinkTimer
+{
+public:
+    LinkTimer();
+
+    void reset(void);
+    void sample(int cmd, qint64 us);
+
+    int timeout(int cmd, int def) const;
+    int estimate(int cmd, int def) const;
+    int samples(int cmd) const { return stat[cmd & 0xff].samples; }
+
+private:
+    struct Stat
+    {
+        qint64 srtt;                        /*!< 平滑均值, 单位 us */
+        qint64 rttvar;                      /*!< 平均偏差, 单位 us */
+        int samples;
+    };
+
+    Stat stat[256];                         /*!< 按指令编号索引 */
+};
+
+#endif // LINKTIMER_H
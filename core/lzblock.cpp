@@ -0,0 +1,206 @@
+#include "lzblock.h"
+#include <string.h>
+
+#define LZ_HASH_BITS                12              /*!< 匹配查找表大小, 2^12 项 */
+#define LZ_LAST_LITERALS            5               /*!< 末尾必须为字面量的字节数 */
+#define LZ_MATCH_LIMIT              12              /*!< 最后一个匹配须在末尾此字节数之前开始 */
+
+static inline unsigned int read32(const unsigned char *p)
+{
+    unsigned int v;
+
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline unsigned int lz_hash(unsigned int seq)
+{
+    return (seq * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/**
+* @brief  写入长度扩展字节, 每字节 255 表示后续还有
+*/
+static inline unsigned char *put_length(unsigned char *op, int len)
+{
+    while(len >= 255)
+    {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (unsigned char)len;
+
+    return op;
+}
+
+/**
+* @brief  写入一个序列
+* @param  [in] op unsigned char*. 输出位置
+* @param  [in] oend unsigned char*. 输出结束位置
+* @param  [in] lit const unsigned char*. 字面量
+* @param  [in] lit_len int. 字面量长度
+* @param  [in] offset int. 匹配距离, 为 0 时是最后一个序列, 没有匹配
+* @param  [in] match_len int. 匹配长度
+* @return 写入后的输出位置, 空间不足时返回 NULL
+*/
+static unsigned char *put_sequence(unsigned char *op, unsigned char *oend, const unsigned char *lit,
+                                   int lit_len, int offset, int match_len)
+{
+    int need = 1 + lit_len + lit_len / 255 + 1 + ((offset != 0) ? 2 + match_len / 255 + 1 : 0);
+    unsigned char *token = op;
+
+    if(oend - op < need)
+        return NULL;
+
+    op++;
+    *token = (unsigned char)(((lit_len >= 15) ? 15 : lit_len) << 4);
+    if(lit_len >= 15)
+        op = put_length(op, lit_len - 15);
+
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if(offset == 0)
+        return op;
+
+    *op++ = (unsigned char)offset;
+    *op++ = (unsigned char)(offset >> 8);
+
+    int ml = match_len - LZ_MIN_MATCH;
+    *token |= (unsigned char)((ml >= 15) ? 15 : ml);
+    if(ml >= 15)
+        op = put_length(op, ml - 15);
+
+    return op;
+}
+
+/**
+* @brief  压缩一块数据
+* @note   单次哈希查找的贪心匹配, 速度优先. 0xFF 填充等重复数据以距离 1 的匹配表示
+* @param  [in] src const char*. 原始数据
+* @param  [in] len int. 原始数据长度
+* @param  [out] dst char*. 压缩数据
+* @param  [in] cap int. 输出空间, 不小于 LZ_BOUND(len) 时一定成功
+* @return 压缩后的长度, 输出空间不足时返回 -1
+*/
+int lz_compress(const char *src, int len, char *dst, int cap)
+{
+    const unsigned char *in = (const unsigned char *)src;
+    unsigned char *op = (unsigned char *)dst;
+    unsigned char *oend = op + cap;
+    int table[1 << LZ_HASH_BITS];
+    int anchor = 0;
+    int i = 0;
+
+    for(int k = 0; k < (1 << LZ_HASH_BITS); k++)
+        table[k] = -1;
+
+    while(i < len - LZ_MATCH_LIMIT)
+    {
+        unsigned int seq = read32(in + i);
+        unsigned int h = lz_hash(seq);
+        int ref = table[h];
+
+        table[h] = i;
+
+        if((ref < 0) || (i - ref > LZ_MAX_OFFSET) || (read32(in + ref) != seq))
+        {
+            i++;
+            continue;
+        }
+
+        int match_len = LZ_MIN_MATCH;
+        while((i + match_len < len - LZ_LAST_LITERALS) && (in[ref + match_len] == in[i + match_len]))
+            match_len++;
+
+        op = put_sequence(op, oend, in + anchor, i - anchor, i - ref, match_len);
+        if(op == NULL)
+            return -1;
+
+        i += match_len;
+        anchor = i;
+    }
+
+    op = put_sequence(op, oend, in + anchor, len - anchor, 0, 0);
+    if(op == NULL)
+        return -1;
+
+    return op - (unsigned char *)dst;
+}
+
+/**
+* @brief  解压一块数据
+* @param  [in] src const char*. 压缩数据
+* @param  [in] len int. 压缩数据长度
+* @param  [out] dst char*. 原始数据
+* @param  [in] cap int. 输出空间
+* @return 解压后的长度, 数据错误或输出空间不足时返回 -1
+*/
+int lz_decompress(const char *src, int len, char *dst, int cap)
+{
+    const unsigned char *ip = (const unsigned char *)src;
+    const unsigned char *iend = ip + len;
+    unsigned char *out = (unsigned char *)dst;
+    unsigned char *op = out;
+    unsigned char *oend = out + cap;
+
+    while(ip < iend)
+    {
+        unsigned int token = *ip++;
+        int lit_len = token >> 4;
+        unsigned int c;
+
+        if(lit_len == 15)
+        {
+            do
+            {
+                if(ip >= iend)
+                    return -1;
+                c = *ip++;
+                lit_len += c;
+            } while(c == 255);
+        }
+
+        if((lit_len > iend - ip) || (lit_len > oend - op))
+            return -1;
+
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        /* 最后一个序列没有匹配 */
+        if(ip == iend)
+            break;
+
+        if(iend - ip < 2)
+            return -1;
+
+        int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if((offset == 0) || (offset > op - out))
+            return -1;
+
+        int match_len = token & 15;
+        if(match_len == 15)
+        {
+            do
+            {
+                if(ip >= iend)
+                    return -1;
+                c = *ip++;
+                match_len += c;
+            } while(c == 255);
+        }
+        match_len += LZ_MIN_MATCH;
+
+        if(match_len > oend - op)
+            return -1;
+
+        /* 距离可小于长度 (重复数据), 逐字节复制 */
+        const unsigned char *m = op - offset;
+        while(match_len-- > 0)
+            *op++ = *m++;
+    }
+
+    return op - out;
+}
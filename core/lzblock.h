@@ -0,0 +1,22 @@
+#ifndef LZBLOCK_H
+#define LZBLOCK_H
+
+/**
+ * @brief LZ4 块格式的压缩与解压, 每块独立解码, 不引用其他块的数据
+ * @note  序列为 令牌 + 字面量长度扩展 + 字面量 + 偏移(2, 小端) + 匹配长度扩展,
+ *        最后一个序列只有字面量; 最后 5 字节为字面量, 最后一个匹配在末尾 12 字节之前开始.
+ *        与 lz4 库的 LZ4_decompress_safe 兼容, bootloader 可直接使用
+ */
+
+#define LZ_MIN_MATCH                4               /*!< 最短匹配长度 */
+#define LZ_MAX_OFFSET               65535           /*!< 最远匹配距离 */
+
+/**
+ * @brief 压缩 len 字节数据所需的最大输出空间
+ */
+#define LZ_BOUND(len)               ((len) + (len) / 255 + 16)
+
+int lz_compress(const char *src, int len, char *dst, int cap);
+int lz_decompress(const char *src, int len, char *dst, int cap);
+
+#endif // LZBLOCK_H
@@ -0,0 +1,179 @@
+#include "multiflasher.h"
+#include "crc32.h"
+
+MultiFlasher::MultiFlasher(QObject *parent) :
+    QObject(parent)
+{
+    baudrate = 0;
+    max_baud = MAX_BAUD_DEFAULT;
+    max_frame = 0;
+    skip_blank = true;
+    compress = true;
+    resume = true;
+    do_boot = false;
+    running = 0;
+    ok_count = 0;
+}
+
+MultiFlasher::~MultiFlasher()
+{
+    clear_sessions();
+}
+
+/**
+ * @brief 开始并行烧写
+ * @param [in] ports QStringList. 串口列表, 每个串口一个会话
+ * @param [in] baudrate int. 波特率, 为 0 时自动探测
+ * @param [in] image FirmwareImage. 固件数据, 所有会话共用同一份映射与CRC
+ * @param [in] window int. 烧写滑动窗口大小
+ * @param [in] boot bool. 完成后是否引导APP
+ */
+void MultiFlasher::start(QStringList ports, int baudrate, FirmwareImage image, int window, bool boot)
+{
+    if(running > 0)
+        return;
+
+    clear_sessions();
+
+    this->image = image;
+    if(!this->image.crc_known())
+        this->image.set_crc(crc32(this->image.data(), this->image.size(), 0));
+    this->baudrate = baudrate;
+    do_boot = boot;
+    ok_count = 0;
+    running = ports.size();
+
+    sessions.resize(ports.size());
+    run_time.start();
+
+    for(int i = 0; i < ports.size(); i++)
+    {
+        Session &s = sessions[i];
+
+        s.port = ports.at(i);
+        s.engine = new FlashEngine();
+        s.thread = new QThread(this);
+        s.state = ST_IDLE;
+        s.engine->set_prog_window(window);
+        s.engine->set_max_baudrate(max_baud);
+        s.engine->set_max_frame(max_frame);
+        s.engine->set_skip_blank(skip_blank);
+        s.engine->set_compress(compress);
+        s.engine->set_resume(resume);
+        s.engine->moveToThread(s.thread);
+
+        connect(s.thread, &QThread::finished, s.engine, &QObject::deleteLater);
+        connect(s.engine, &FlashEngine::progress, this, [this, i](int value, int max) {
+            emit session_progress(i, value, max);
+        });
+        connect(s.engine, &FlashEngine::finished, this, [this, i](int op, bool ok, QString msg) {
+            engine_finished(i, op, ok, msg);
+        });
+
+        s.thread->start();
+    }
+
+    for(int i = 0; i < sessions.size(); i++)
+    {
+        sessions[i].time.start();
+        set_state(i, ST_CONNECT, "");
+        QMetaObject::invokeMethod(sessions[i].engine, "open_device", Qt::QueuedConnection,
+                                  Q_ARG(QString, sessions[i].port), Q_ARG(int, baudrate));
+    }
+}
+
+/**
+ * @brief 中止所有会话
+ */
+void MultiFlasher::stop(void)
+{
+    for(int i = 0; i < sessions.size(); i++)
+    {
+        if((sessions[i].state == ST_DONE) || (sessions[i].state == ST_FAILED))
+            continue;
+
+        /* 之后到达的结果将被忽略 */
+        set_state(i, ST_FAILED, "操作已取消");
+        QMetaObject::invokeMethod(sessions[i].engine, "close_device", Qt::QueuedConnection);
+        end_session(i, false);
+    }
+}
+
+void MultiFlasher::engine_finished(int index, int op, bool ok, QString msg)
+{
+    Session &s = sessions[index];
+
+    if((s.state == ST_DONE) || (s.state == ST_FAILED))
+        return;
+
+    if(!ok)
+    {
+        set_state(index, ST_FAILED, msg);
+        QMetaObject::invokeMethod(s.engine, "close_device", Qt::QueuedConnection);
+        end_session(index, false);
+        return;
+    }
+
+    switch(op)
+    {
+    case FlashEngine::OP_CONNECT:
+        set_state(index, ST_PROGRAM, "");
+        QMetaObject::invokeMethod(s.engine, "program_image", Qt::QueuedConnection, Q_ARG(FirmwareImage, image));
+        break;
+
+    case FlashEngine::OP_PROGRAM:
+        if(do_boot)
+        {
+            set_state(index, ST_BOOT, "");
+            QMetaObject::invokeMethod(s.engine, "boot", Qt::QueuedConnection);
+            break;
+        }
+
+        set_state(index, ST_DONE, "");
+        QMetaObject::invokeMethod(s.engine, "close_device", Qt::QueuedConnection);
+        end_session(index, true);
+        break;
+
+    case FlashEngine::OP_BOOT:
+        set_state(index, ST_DONE, "");
+        end_session(index, true);
+        break;
+
+    default:
+        break;
+    }
+}
+
+void MultiFlasher::set_state(int index, int state, QString msg)
+{
+    sessions[index].state = state;
+    emit session_state(index, state, msg);
+}
+
+void MultiFlasher::end_session(int index, bool ok)
+{
+    if(ok)
+        ok_count++;
+
+    emit session_finished(index, ok, sessions[index].time.elapsed());
+
+    if(--running == 0)
+        emit all_finished(ok_count, sessions.size(), run_time.elapsed());
+}
+
+/**
+ * @brief 关闭串口并结束所有会话线程
+ */
+void MultiFlasher::clear_sessions(void)
+{
+    for(int i = 0; i < sessions.size(); i++)
+    {
+        QMetaObject::invokeMethod(sessions[i].engine, "close_device", Qt::BlockingQueuedConnection);
+        sessions[i].thread->quit();
+        sessions[i].thread->wait();
+        delete sessions[i].thread;
+    }
+
+    sessions.clear();
+    running = 0;
+}
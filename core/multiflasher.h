@@ -0,0 +1,84 @@
+#ifndef MULTIFLASHER_H
+#define MULTIFLASHER_H
+
+#include <QObject>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QStringList>
+#include "flashengine.h"
+
+/**
+ * @brief 多串口并行烧写
+ * @note  每个串口一个 FlashEngine, 各自运行于独立线程, 依次执行 连接 -> 擦除/烧写/校验 -> [引导].
+ *        所有会话共用同一份固件映射 (只读), 固件CRC在开始前只计算一次
+ */
+class MultiFlasher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 会话状态
+     */
+    enum State
+    {
+        ST_IDLE = 0,
+        ST_CONNECT,         /*!< 正在连接 */
+        ST_PROGRAM,         /*!< 正在擦除/烧写/校验 */
+        ST_BOOT,            /*!< 正在引导 */
+        ST_DONE,            /*!< 成功 */
+        ST_FAILED           /*!< 失败 */
+    };
+
+    explicit MultiFlasher(QObject *parent = 0);
+    ~MultiFlasher();
+
+    bool is_running(void) const { return running > 0; }
+    int session_count(void) const { return sessions.size(); }
+    void set_max_baudrate(int baudrate) { max_baud = baudrate; }
+    void set_max_frame(int bytes) { max_frame = bytes; }
+    void set_skip_blank(bool enable) { skip_blank = enable; }
+    void set_compress(bool enable) { compress = enable; }
+    void set_resume(bool enable) { resume = enable; }
+
+public slots:
+    void start(QStringList ports, int baudrate, FirmwareImage image, int window, bool boot);
+    void stop(void);
+
+signals:
+    void session_state(int index, int state, QString msg);
+    void session_progress(int index, int value, int max);
+    void session_finished(int index, bool ok, qint64 elapsed_ms);
+    void all_finished(int ok_count, int total, qint64 elapsed_ms);
+
+private:
+    struct Session
+    {
+        QString port;
+        FlashEngine *engine;
+        QThread *thread;
+        int state;
+        QElapsedTimer time;
+    };
+
+    QVector<Session> sessions;
+    FirmwareImage image;                    /*!< 所有会话共用, 会话结束前保持映射 */
+    int baudrate;
+    int max_baud;                           /*!< 同步后协商的最高波特率 */
+    int max_frame;                          /*!< 数据帧长度上限, 为 0 时使用设备报告的长度 */
+    bool skip_blank;
+    bool compress;
+    bool resume;
+    bool do_boot;
+    int running;
+    int ok_count;
+    QElapsedTimer run_time;
+
+    void engine_finished(int index, int op, bool ok, QString msg);
+    void set_state(int index, int state, QString msg);
+    void end_session(int index, bool ok);
+    void clear_sessions(void);
+};
+
+#endif // MULTIFLASHER_H
@@ -0,0 +1,57 @@
+#include "progresume.h"
+#include "udidstore.h"
+#include <QSettings>
+#include <QStringList>
+#include <QMutex>
+
+/* 记录格式: 固件摘要,已确认的位置,记录序号 */
+#define RESUME_DIGEST               0
+#define RESUME_POS                  1
+#define RESUME_FIELDS               2
+
+static QMutex resume_mutex;
+
+/**
+* @brief  读取断点
+* @param  [in] udid QByteArray. 设备 UDID
+* @param  [out] digest QByteArray. 断点所属的固件摘要, 由调用者与当前固件比较
+* @return 已确认的位置, 没有记录时为 0
+*/
+long ProgResume::load(const QByteArray &udid, QByteArray *digest)
+{
+    QMutexLocker locker(&resume_mutex);
+    QSettings ini(UdidStore::file(), QSettings::IniFormat);
+    UdidStore store(&ini, "ProgResume", RESUME_FIELDS, PROG_RESUME_UDID_MAX);
+    QStringList list;
+
+    if(!store.read(udid, &list))
+        return 0;
+
+    *digest = QByteArray::fromHex(list.at(RESUME_DIGEST).toLatin1());
+    long pos = list.at(RESUME_POS).toLong();
+    return (pos > 0) ? pos : 0;
+}
+
+/**
+ * @brief 记录断点, 设备记录超过 PROG_RESUME_UDID_MAX 条时删除最旧的
+ */
+void ProgResume::save(const QByteArray &udid, const QByteArray &digest, long pos)
+{
+    QMutexLocker locker(&resume_mutex);
+    QSettings ini(UdidStore::file(), QSettings::IniFormat);
+    UdidStore store(&ini, "ProgResume", RESUME_FIELDS, PROG_RESUME_UDID_MAX);
+
+    store.write(udid, QStringList() << QString::fromLatin1(digest.toHex()) << QString::number(pos));
+}
+
+/**
+ * @brief 烧写完成或重新擦除后删除断点
+ */
+void ProgResume::clear(const QByteArray &udid)
+{
+    QMutexLocker locker(&resume_mutex);
+    QSettings ini(UdidStore::file(), QSettings::IniFormat);
+    UdidStore store(&ini, "ProgResume", RESUME_FIELDS, PROG_RESUME_UDID_MAX);
+
+    store.remove(udid);
+}
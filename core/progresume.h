@@ -0,0 +1,21 @@
+#ifndef PROGRESUME_H
+#define PROGRESUME_H
+
+#include <QByteArray>
+
+#define PROG_RESUME_UDID_MAX        16              /*!< 保留的设备记录数量, 超出时删除最旧的 */
+
+/**
+ * @brief 烧写断点
+ * @note  整片烧写中断时按设备 UDID 记录已确认的固件位置与固件摘要, 保存在程序目录的 config.ini 中
+ *        [ProgResume] 组下. 下次烧写同一固件时从断点继续, 不必重新擦除. 所有函数均可在多个烧写线程中同时调用
+ */
+class ProgResume
+{
+public:
+    static long load(const QByteArray &udid, QByteArray *digest);
+    static void save(const QByteArray &udid, const QByteArray &digest, long pos);
+    static void clear(const QByteArray &udid);
+};
+
+#endif // PROGRESUME_H
@@ -0,0 +1,75 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+/* Defination ------------------------------------------------------------------------------------*/
+/**
+* @breif 基础参数
+**/
+#define BL_PROTOCOL_VERSION 		"0.1.1.0"     	/*!< 当前协议版本 */
+
+#define PROTO_INSYNC				0xA5            /*!< Magic code of INSYNC */
+#define PROTO_EOC					0xF7            /*!< Magic code of EOC */
+#define PROTO_PROG_MULTI_MAX        64	            /*!< 最大单次烧写数据长度,单位:byte */
+#define PROTO_REPLY_MAX             255	            /*!< 最大返回数据长度,单位:byte */
+#define PROTO_BAUD_REVERT_TIME      500             /*!< 切换波特率后等待确认的时间,单位:ms */
+
+/**
+* @breif 返回状态
+**/
+#define PROTO_OK					0x10            /*!< 操作成功 */
+#define PROTO_FAILED				0x11            /*!< 操作失败 */
+#define PROTO_INVALID				0x13	        /*!< 指令无效 */
+
+/**
+* @breif 操作指令
+**/
+#define PROTO_GET_SYNC				0x21            /*!< 测试同步 */
+#define PROTO_SET_BAUD              0x22            /*!< 切换波特率, 参数: 波特率(4). 以原波特率应答后切换,
+                                                         PROTO_BAUD_REVERT_TIME 内未在新波特率下收到有效指令则恢复原波特率 */
+
+#define PROTO_GET_UDID				0x31            /*!< 读取芯片指定地址上的 UDID 12字节的值 */
+#define PROTO_GET_FW_SIZE           0x32            /*!< 获取固件区大小 */
+
+#define PROTO_GET_BL_REV            0x41            /*!< 获取Bootloader版本 */
+#define PROTO_GET_ID                0x42            /*!< 获取电路板型号,包含版本 */
+#define PROTO_GET_SN                0x43            /*!< 获取电路板序列号 */
+#define PROTO_GET_REV               0x44            /*!< 获取电路板版本 */
+#define PROTO_GET_FLASH_STRC        0x45            /*!< 获取FLASH结构描述 */
+#define PROTO_GET_DES               0x46            /*!< 获取以 ASCII 格式读取设备描述 */
+#define PROTO_GET_CAPS              0x47            /*!< 获取扩展功能, 返回 功能标志(4) 解压缓冲区大小(4) */
+#define PROTO_GET_FRAME_MAX         0x48            /*!< 获取烧写指令的最大数据长度, 返回 长度(4). 大于 255 时支持 PROTO_PROG_MULTI_EXT,
+                                                         不支持此指令的设备按 (PROTO_PROG_MULTI_MAX - 1) * 4 */
+
+#define PROTO_CHIP_ERASE			0x51            /*!< 擦除设备 Flash 并复位编程指针 */
+#define PROTO_PROG_MULTI			0x52            /*!< 在当前编程指针位置写入指定字节的数据，并使编程指针向后移动到下一段的位置 */
+#define PROTO_GET_CRC				0x53	        /*!< 计算并返回CRC校验值 */
+#define PROTO_BOOT					0x54            /*!< 引导 APP 程序 */
+
+/**
+* @breif 带参数的操作指令, 格式为 指令 + 参数长度 + 参数 + EOC, 参数均为小端序,
+*        地址均为相对固件区起始位置的偏移
+**/
+#define PROTO_SECTOR_ERASE          0x55            /*!< 擦除 [偏移, 偏移+长度) 覆盖的扇区, 参数: 偏移(4) 长度(4) */
+#define PROTO_GET_RANGE_CRC         0x56            /*!< 计算并返回 [偏移, 偏移+长度) 的CRC校验值, 参数: 偏移(4) 长度(4) */
+#define PROTO_SET_PROG_ADDR         0x57            /*!< 设置编程指针, 参数: 偏移(4) */
+#define PROTO_PROG_SKIP             0x58            /*!< 编程指针向后移动, 跳过的部分保持擦除后的 0xFF, 参数: 长度(4) */
+#define PROTO_PROG_LZ               0x59            /*!< 解压后在当前编程指针位置写入, 参数: 原始长度(2) LZ4块格式的压缩数据.
+                                                         原始长度不超过解压缓冲区大小 */
+#define PROTO_PROG_MULTI_EXT        0x5A            /*!< 同 PROTO_PROG_MULTI, 格式为 指令 + 数据长度(2, 小端序) + 数据 + EOC,
+                                                         数据长度不超过 PROTO_GET_FRAME_MAX 的返回值 */
+#define PROTO_GET_PROG_ADDR         0x5B            /*!< 获取编程指针, 无参数 (格式为 指令 + EOC), 返回 偏移(4). 用于从断点继续烧写 */
+
+/**
+* @breif 扩展功能标志, 由 PROTO_GET_CAPS 返回
+**/
+#define PROTO_CAP_LZ                0x00000001      /*!< 支持 PROTO_PROG_LZ */
+
+/**
+* @breif 指令返回值
+**/
+#define REPLY_TIMEOUT               0               /*!< 未收到应答 */
+#define REPLY_OK                    1               /*!< 操作成功 */
+#define REPLY_INVALID               2               /*!< 指令无效 */
+#define REPLY_FAILED                3               /*!< 操作失败 */
+
+#endif // PROTOCOL_H
@@ -0,0 +1,236 @@
+#include "replyparser.h"
+#include <string.h>
+
+ReplyParser::ReplyParser()
+{
+    expect_len = 0;
+    garbage_count = 0;
+    reset();
+}
+
+/**
+ * @brief 取得状态字节对应的应答结果
+ */
+static int status_result(unsigned char c)
+{
+    switch(c)
+    {
+    case PROTO_OK:
+        return REPLY_OK;
+    case PROTO_INVALID:
+        return REPLY_INVALID;
+    case PROTO_FAILED:
+        return REPLY_FAILED;
+    default:
+        return REPLY_TIMEOUT;
+    }
+}
+
+/**
+ * @brief 清空已缓存的数据, 等待新的应答
+ */
+void ReplyParser::reset(void)
+{
+    count = 0;
+    payload_start = 0;
+    payload_size = 0;
+    pending = REPLY_TIMEOUT;
+    ready = REPLY_TIMEOUT;
+    rest_pos = 0;
+    rest_len = 0;
+}
+
+/**
+ * @brief 设定下一个应答的数据长度并清空缓存
+ * @param [in] len int. 数据长度, REPLY_LEN_VARIABLE 为变长
+ */
+void ReplyParser::expect(int len)
+{
+    expect_len = len;
+    reset();
+}
+
+/**
+ * @brief 设定连续发出的下一条指令的应答长度, 保留尚未解析的后续数据
+ * @param [in] len int. 数据长度, REPLY_LEN_VARIABLE 为变长
+ */
+void ReplyParser::expect_next(int len)
+{
+    expect_len = len;
+    count = 0;
+    payload_start = 0;
+    payload_size = 0;
+}
+
+/**
+* @brief  解析收到的数据, 完成一个应答即返回
+* @param  [in] data const char*. 收到的数据
+* @param  [in] len int. 数据长度, 为 0 时只解析之前保留的数据
+* @param  [out] used int*. 本次消耗的字节数, 剩余字节应再次调用 feed 解析
+* @return 0,应答未完成.1,正确.2,无效.3,失败
+*/
+int ReplyParser::feed(const char *data, int len, int *used)
+{
+    *used = 0;
+
+    if(ready != REPLY_TIMEOUT)
+    {
+        int result = ready;
+        ready = REPLY_TIMEOUT;
+        return result;
+    }
+
+    while(rest_pos < rest_len)
+    {
+        int result = step(rest[rest_pos++]);
+        if(result != REPLY_TIMEOUT)
+            return result;
+    }
+    rest_pos = 0;
+    rest_len = 0;
+
+    int i = 0;
+    while(i < len)
+    {
+        int result = step(data[i++]);
+        if(result != REPLY_TIMEOUT)
+        {
+            *used = i;
+            return result;
+        }
+    }
+
+    *used = len;
+    return REPLY_TIMEOUT;
+}
+
+/**
+* @brief  等待应答超时, 确认定长应答开头的错误状态
+* @return 是否确认了一个错误应答, 是则由下一次调用 feed 返回
+*/
+bool ReplyParser::flush(void)
+{
+    if(pending == REPLY_TIMEOUT)
+        return false;
+
+    ready = pending;
+    take_pending();
+    return true;
+}
+
+/**
+ * @brief 确认开头的错误状态为错误应答, 之后的字节留待下一个应答重新解析
+ */
+void ReplyParser::take_pending(void)
+{
+    int carry = count - 2;
+    int remain = rest_len - rest_pos;
+
+    memmove(rest + carry, rest + rest_pos, remain);
+    memcpy(rest, buf + 2, carry);
+    rest_pos = 0;
+    rest_len = carry + remain;
+
+    pending = REPLY_TIMEOUT;
+    payload_start = 0;
+    payload_size = 0;
+    count = 0;
+}
+
+/**
+* @brief  解析一个字节
+* @param  [in] c unsigned char. 收到的字节
+* @return 应答结果, 未完成时为 REPLY_TIMEOUT
+*/
+int ReplyParser::step(unsigned char c)
+{
+    /* 缓存已满仍未找到应答结尾, 丢弃旧数据, 定长应答保留可能构成应答的末尾部分 */
+    if(count == (int)sizeof(buf))
+    {
+        int keep = (expect_len == REPLY_LEN_VARIABLE) ? 0 : expect_len + 1;
+        memmove(buf, buf + count - keep, keep);
+        garbage_count += count - keep;
+        count = keep;
+        pending = REPLY_TIMEOUT;
+    }
+
+    buf[count++] = c;
+
+    int result = REPLY_TIMEOUT;
+    if((count >= 2) && (buf[count - 2] == PROTO_INSYNC))
+        result = status_result(c);
+
+    /* 数据已收满却不以 INSYNC + 状态 结尾, 开头的错误状态即为错误应答 */
+    if((pending != REPLY_TIMEOUT) && (count == expect_len + 2) && (result == REPLY_TIMEOUT))
+    {
+        result = pending;
+        take_pending();
+        return result;
+    }
+
+    if(result == REPLY_TIMEOUT)
+        return REPLY_TIMEOUT;
+
+    int body = count - 2;
+
+    if(expect_len == REPLY_LEN_VARIABLE)
+    {
+        payload_start = 0;
+        payload_size = (result == REPLY_OK) ? body : 0;
+    }
+    else if(body < expect_len)
+    {
+        /* 定长数据中也会出现 INSYNC + 状态, 开头的错误状态待数据收满或超时后确定 */
+        if((body == 0) && (result != REPLY_OK))
+            pending = result;
+        return REPLY_TIMEOUT;
+    }
+    else
+    {
+        /* 错误应答不带数据, 之前的字节均为无效数据 */
+        int size = (result == REPLY_OK) ? expect_len : 0;
+
+        payload_start = body - size;
+        payload_size = size;
+        garbage_count += payload_start;
+    }
+
+    pending = REPLY_TIMEOUT;
+    count = 0;
+    return result;
+}
+
+/**
+* @brief  获取指令应答的数据长度
+* @param  [in] cmd int. 指令
+* @return 数据长度, REPLY_LEN_VARIABLE 为变长
+*/
+int ReplyParser::reply_length(int cmd)
+{
+    switch(cmd)
+    {
+    case PROTO_GET_FW_SIZE:
+    case PROTO_GET_FRAME_MAX:
+    case PROTO_GET_PROG_ADDR:
+    case PROTO_GET_CRC:
+    case PROTO_GET_RANGE_CRC:
+        return 4;
+
+    case PROTO_GET_CAPS:
+        return 8;
+
+    case PROTO_GET_UDID:
+        return 12;
+
+    case PROTO_GET_BL_REV:
+    case PROTO_GET_ID:
+    case PROTO_GET_SN:
+    case PROTO_GET_REV:
+    case PROTO_GET_FLASH_STRC:
+    case PROTO_GET_DES:
+        return REPLY_LEN_VARIABLE;
+
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef REPLYPARSER_H
+#define REPLYPARSER_H
+
+#include "protocol.h"
+
+#define REPLY_LEN_VARIABLE          (-1)            /*!< 变长应答 (ASCII描述等), 以 INSYNC + 状态 结尾 */
+
+/**
+ * @brief 应答帧流式解析器
+ * @note  逐字节解析 [数据][INSYNC][状态] 格式的应答. 数据到达即可完成解析,
+ *        不依赖于单次读取的边界; 同一次读取中的多个应答依次返回; 遇到无法识别的字节时丢弃并重新同步.
+ *        解析过程不分配内存, 应答数据保存在内部缓存中, 在下一次调用 feed 前有效.
+ *        定长应答开头的错误状态也可能是数据, 收满数据或超时 (flush) 后才能确定
+ */
+class ReplyParser
+{
+public:
+    ReplyParser();
+
+    void reset(void);
+    void expect(int len);
+    void expect_next(int len);
+    int feed(const char *data, int len, int *used);
+    bool flush(void);
+
+    const char *payload(void) const { return (const char *)buf + payload_start; }
+    int payload_len(void) const { return payload_size; }
+    long garbage(void) const { return garbage_count; }
+
+    static int reply_length(int cmd);
+
+private:
+    int step(unsigned char c);
+    void take_pending(void);
+
+    unsigned char buf[PROTO_REPLY_MAX + 2];
+    unsigned char rest[PROTO_REPLY_MAX + 2];  /*!< 确认错误应答后需要重新解析的后续数据 */
+    int rest_pos;
+    int rest_len;
+    int count;                      /*!< 当前已缓存字节数 */
+    int expect_len;                 /*!< 期望的数据长度, REPLY_LEN_VARIABLE 为变长 */
+    int payload_start;
+    int payload_size;
+    int pending;                    /*!< 定长应答开头的错误状态, 尚未确定时为 REPLY_TIMEOUT */
+    int ready;                      /*!< 已确定的错误应答, 下一次调用 feed 时返回 */
+    long garbage_count;             /*!< 重新同步时丢弃的字节数 */
+};
+
+#endif // REPLYPARSER_H
@@ -0,0 +1,538 @@
+#include "sparseimage.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <algorithm>
+
+#define ELF_PT_LOAD                 1               /*!< 需要装载的程序段 */
+
+SparseImage::SparseImage()
+{
+}
+
+/**
+* @brief  按扩展名判断是否为带地址的固件文件
+* @param  [in] path QString. 文件路径
+* @return 是否为 HEX, S-record 或 ELF 文件
+*/
+bool SparseImage::is_sparse_file(const QString &path)
+{
+    static const char *suffix[] =
+    {
+        "hex", "ihx", "ihex",
+        "s19", "s28", "s37", "srec", "mot",
+        "elf", "axf", "out"
+    };
+
+    QString s = QFileInfo(path).suffix().toLower();
+
+    for(unsigned int i = 0; i < sizeof(suffix) / sizeof(suffix[0]); i++)
+    {
+        if(s == suffix[i])
+            return true;
+    }
+
+    return false;
+}
+
+/**
+* @brief  读取固件文件, 按扩展名选择格式, 无法识别时按文件内容判断
+* @param  [in] path QString. 文件路径
+* @return 是否成功. 失败原因由 error_string 返回
+*/
+bool SparseImage::load(const QString &path)
+{
+    QFile file(path);
+
+    clear();
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    QByteArray content = file.readAll();
+    file.close();
+
+    QString s = QFileInfo(path).suffix().toLower();
+
+    if((s == "hex") || (s == "ihx") || (s == "ihex"))
+        return load_hex(content);
+    if((s == "s19") || (s == "s28") || (s == "s37") || (s == "srec") || (s == "mot"))
+        return load_srec(content);
+    if(content.startsWith("\x7f" "ELF"))
+        return load_elf(content);
+    if(content.startsWith(":"))
+        return load_hex(content);
+    if(content.startsWith("S"))
+        return load_srec(content);
+
+    error = "无法识别的固件格式";
+    return false;
+}
+
+void SparseImage::clear(void)
+{
+    segs.clear();
+    error.clear();
+}
+
+uint SparseImage::start(void) const
+{
+    return segs.isEmpty() ? 0 : segs.first().address;
+}
+
+/**
+ * @brief 最后一段之后的地址
+ */
+uint SparseImage::end(void) const
+{
+    return segs.isEmpty() ? 0 : segs.last().address + segs.last().data.size();
+}
+
+/**
+ * @brief 所有段的数据总长度
+ */
+qint64 SparseImage::data_size(void) const
+{
+    qint64 size = 0;
+
+    for(int i = 0; i < segs.size(); i++)
+        size += segs.at(i).data.size();
+
+    return size;
+}
+
+bool SparseImage::fail(const QString &msg, int line)
+{
+    segs.clear();
+    error = (line > 0) ? QString("第 %1 行: %2").arg(line).arg(msg) : msg;
+    return false;
+}
+
+/**
+ * @brief 添加一段数据, 与上一段连续时直接追加 (HEX/S-record 文件中的常见情况)
+ */
+void SparseImage::add(uint address, const char *data, int len)
+{
+    if(len <= 0)
+        return;
+
+    if(!segs.isEmpty())
+    {
+        ImageSegment &last = segs.last();
+        if(last.address + (uint)last.data.size() == address)
+        {
+            last.data.append(data, len);
+            return;
+        }
+    }
+
+    ImageSegment s;
+    s.address = address;
+    s.data = QByteArray(data, len);
+    segs.append(s);
+}
+
+/**
+ * @brief 按地址排序并合并相邻或重叠的段, 重叠部分以排序后靠后的段为准
+ */
+void SparseImage::finish(void)
+{
+    std::stable_sort(segs.begin(), segs.end(), [](const ImageSegment &a, const ImageSegment &b) {
+        return a.address < b.address;
+    });
+
+    QVector<ImageSegment> out;
+
+    for(int i = 0; i < segs.size(); i++)
+    {
+        const ImageSegment &s = segs.at(i);
+
+        if(!out.isEmpty())
+        {
+            ImageSegment &last = out.last();
+            qint64 last_end = (qint64)last.address + last.data.size();
+
+            if((qint64)s.address <= last_end)
+            {
+                int pos = s.address - last.address;
+                qint64 s_end = (qint64)s.address + s.data.size();
+
+                if(s_end > last_end)
+                    last.data.resize(s_end - last.address);
+                last.data.replace(pos, s.data.size(), s.data);
+                continue;
+            }
+        }
+
+        out.append(s);
+    }
+
+    segs = out;
+}
+
+static int hex_value(char c)
+{
+    if((c >= '0') && (c <= '9'))
+        return c - '0';
+    if((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    if((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    return -1;
+}
+
+/**
+* @brief  将 2n 个十六进制字符转换为 n 个字节
+* @return 是否全部为十六进制字符
+*/
+static bool hex_bytes(const char *p, int n, unsigned char *out)
+{
+    for(int i = 0; i < n; i++)
+    {
+        int h = hex_value(p[2 * i]);
+        int l = hex_value(p[2 * i + 1]);
+
+        if((h < 0) || (l < 0))
+            return false;
+
+        out[i] = (unsigned char)((h << 4) | l);
+    }
+
+    return true;
+}
+
+/**
+* @brief  取出下一行, 去掉首尾空白
+* @param  [in,out] p const char**. 当前位置, 返回时指向下一行
+* @param  [in] end const char*. 结束位置
+* @param  [out] ls const char**. 行首
+* @return 行长度
+*/
+static int next_line(const char **p, const char *end, const char **ls)
+{
+    const char *s = *p;
+    const char *e;
+
+    while((*p < end) && (**p != '\n'))
+        (*p)++;
+    e = *p;
+    if(*p < end)
+        (*p)++;
+
+    while((s < e) && ((*s == ' ') || (*s == '\t')))
+        s++;
+    while((e > s) && ((e[-1] == '\r') || (e[-1] == ' ') || (e[-1] == '\t')))
+        e--;
+
+    *ls = s;
+    return e - s;
+}
+
+/**
+* @brief  解析 Intel HEX 文件
+* @param  [in] text QByteArray. 文件内容
+* @return 是否成功
+*/
+bool SparseImage::load_hex(const QByteArray &text)
+{
+    const char *p = text.constData();
+    const char *end = p + text.size();
+    unsigned char rec[255 + 5];
+    uint upper = 0;
+    int line = 0;
+
+    segs.clear();
+    error.clear();
+
+    while(p < end)
+    {
+        const char *ls;
+        int len = next_line(&p, end, &ls);
+        line++;
+
+        if(len == 0)
+            continue;
+
+        if(ls[0] != ':')
+            return fail("不是 Intel HEX 记录", line);
+
+        int n = (len - 1) / 2;
+        if(((len - 1) % 2 != 0) || (n < 5) || (n > (int)sizeof(rec)))
+            return fail("记录长度错误", line);
+
+        if(!hex_bytes(ls + 1, n, rec))
+            return fail("非法字符", line);
+
+        if(rec[0] + 5 != n)
+            return fail("记录长度错误", line);
+
+        unsigned char sum = 0;
+        for(int i = 0; i < n; i++)
+            sum += rec[i];
+        if(sum != 0)
+            return fail("校验和错误", line);
+
+        uint offset = ((uint)rec[1] << 8) | rec[2];
+        const unsigned char *data = rec + 4;
+
+        switch(rec[3])
+        {
+        case 0x00:          // 数据
+            add(upper + offset, (const char *)data, rec[0]);
+            break;
+
+        case 0x01:          // 文件结束
+            finish();
+            return true;
+
+        case 0x02:          // 扩展段地址
+            if(rec[0] != 2)
+                return fail("记录长度错误", line);
+            upper = (((uint)data[0] << 8) | data[1]) << 4;
+            break;
+
+        case 0x04:          // 扩展线性地址
+            if(rec[0] != 2)
+                return fail("记录长度错误", line);
+            upper = (((uint)data[0] << 8) | data[1]) << 16;
+            break;
+
+        case 0x03:          // 起始地址, 与烧写无关
+        case 0x05:
+            break;
+
+        default:
+            return fail("不支持的记录类型", line);
+        }
+    }
+
+    finish();
+    return true;
+}
+
+/**
+* @brief  解析 Motorola S-record 文件
+* @param  [in] text QByteArray. 文件内容
+* @return 是否成功
+*/
+bool SparseImage::load_srec(const QByteArray &text)
+{
+    const char *p = text.constData();
+    const char *end = p + text.size();
+    unsigned char rec[255 + 1];
+    int line = 0;
+
+    segs.clear();
+    error.clear();
+
+    while(p < end)
+    {
+        const char *ls;
+        int len = next_line(&p, end, &ls);
+        line++;
+
+        if(len == 0)
+            continue;
+
+        if((len < 4) || (ls[0] != 'S') || (ls[1] < '0') || (ls[1] > '9'))
+            return fail("不是 S-record 记录", line);
+
+        int type = ls[1] - '0';
+        int n = (len - 2) / 2;
+        if(((len - 2) % 2 != 0) || (n < 2) || (n > (int)sizeof(rec)))
+            return fail("记录长度错误", line);
+
+        if(!hex_bytes(ls + 2, n, rec))
+            return fail("非法字符", line);
+
+        if(rec[0] + 1 != n)
+            return fail("记录长度错误", line);
+
+        /* 校验和为长度, 地址, 数据之和的反码 */
+        unsigned char sum = 0;
+        for(int i = 0; i < n; i++)
+            sum += rec[i];
+        if(sum != 0xff)
+            return fail("校验和错误", line);
+
+        int addr_len;
+        switch(type)
+        {
+        case 1:
+            addr_len = 2;
+            break;
+        case 2:
+            addr_len = 3;
+            break;
+        case 3:
+            addr_len = 4;
+            break;
+        case 7:             // 结束记录
+        case 8:
+        case 9:
+            finish();
+            return true;
+        default:            // 头部与计数记录
+            continue;
+        }
+
+        if(rec[0] < addr_len + 1)
+            return fail("记录长度错误", line);
+
+        uint addr = 0;
+        for(int i = 0; i < addr_len; i++)
+            addr = (addr << 8) | rec[1 + i];
+
+        add(addr, (const char *)rec + 1 + addr_len, rec[0] - addr_len - 1);
+    }
+
+    finish();
+    return true;
+}
+
+static quint64 read_le(const QByteArray &d, qint64 pos, int len)
+{
+    quint64 v = 0;
+
+    for(int i = len - 1; i >= 0; i--)
+        v = (v << 8) | (unsigned char)d.at(pos + i);
+
+    return v;
+}
+
+/**
+* @brief  解析 ELF 文件, 取出所有 PT_LOAD 段在文件中的内容, 地址使用装载地址 (p_paddr)
+* @note   .data 等段的初始值按装载地址存放在 FLASH 中, 不能使用运行地址
+* @param  [in] file QByteArray. 文件内容
+* @return 是否成功
+*/
+bool SparseImage::load_elf(const QByteArray &file)
+{
+    qint64 size = file.size();
+
+    segs.clear();
+    error.clear();
+
+    if((size < 52) || !file.startsWith("\x7f" "ELF"))
+        return fail("不是 ELF 文件", 0);
+
+    bool is64 = (file.at(4) == 2);
+    if((file.at(4) != 1) && !is64)
+        return fail("不支持的 ELF 类型", 0);
+    if(file.at(5) != 1)
+        return fail("只支持小端序 ELF 文件", 0);
+    if(is64 && (size < 64))
+        return fail("ELF 文件头不完整", 0);
+
+    quint64 phoff = is64 ? read_le(file, 0x20, 8) : read_le(file, 0x1C, 4);
+    int phentsize = read_le(file, is64 ? 0x36 : 0x2A, 2);
+    int phnum = read_le(file, is64 ? 0x38 : 0x2C, 2);
+
+    if((phentsize < (is64 ? 56 : 32)) || (phoff + (quint64)phentsize * phnum > (quint64)size))
+        return fail("ELF 程序头不完整", 0);
+
+    for(int i = 0; i < phnum; i++)
+    {
+        qint64 ph = phoff + (qint64)i * phentsize;
+        quint64 offset, paddr, filesz;
+
+        if(read_le(file, ph, 4) != ELF_PT_LOAD)
+            continue;
+
+        if(is64)
+        {
+            offset = read_le(file, ph + 8, 8);
+            paddr = read_le(file, ph + 24, 8);
+            filesz = read_le(file, ph + 32, 8);
+        }
+        else
+        {
+            offset = read_le(file, ph + 4, 4);
+            paddr = read_le(file, ph + 12, 4);
+            filesz = read_le(file, ph + 16, 4);
+        }
+
+        if(filesz == 0)
+            continue;
+
+        if((offset + filesz > (quint64)size) || (paddr + filesz > 0x100000000ULL))
+            return fail(QString("程序段 %1 超出范围").arg(i), 0);
+
+        add((uint)paddr, file.constData() + offset, (int)filesz);
+    }
+
+    finish();
+    return true;
+}
+
+/**
+ * @brief 将每段的起止地址扩展到 alignment 的整数倍, 扩展部分填充 fill, 扩展后相接的段合并
+ * @param [in] alignment uint. 对齐字节数
+ * @param [in] fill char. 填充值
+ */
+void SparseImage::align(uint alignment, char fill)
+{
+    QVector<ImageSegment> out;
+
+    for(int i = 0; i < segs.size(); i++)
+    {
+        const ImageSegment &s = segs.at(i);
+        uint a0 = s.address - s.address % alignment;
+
+        if(!out.isEmpty())
+        {
+            ImageSegment &last = out.last();
+            uint last_end = last.address + last.data.size();
+            uint last_end_aligned = last_end + (alignment - last_end % alignment) % alignment;
+
+            if(a0 < last_end_aligned)
+            {
+                last.data.append(QByteArray(s.address - last_end, fill));
+                last.data.append(s.data);
+                continue;
+            }
+        }
+
+        ImageSegment n;
+        n.address = a0;
+        n.data = QByteArray(s.address - a0, fill);
+        n.data.append(s.data);
+        out.append(n);
+    }
+
+    for(int i = 0; i < out.size(); i++)
+    {
+        uint tail = out.at(i).data.size() % alignment;
+        if(tail != 0)
+            out[i].data.append(QByteArray(alignment - tail, fill));
+    }
+
+    segs = out;
+}
+
+/**
+* @brief  展开为连续数据
+* @param  [in] base uint. 起始地址
+* @param  [in] size uint. 长度
+* @param  [in] fill char. 空隙的填充值
+* @return [base, base+size) 的数据
+*/
+QByteArray SparseImage::flatten(uint base, uint size, char fill) const
+{
+    QByteArray out(size, fill);
+
+    for(int i = 0; i < segs.size(); i++)
+    {
+        const ImageSegment &s = segs.at(i);
+        qint64 from = qMax((qint64)s.address, (qint64)base);
+        qint64 to = qMin((qint64)s.address + s.data.size(), (qint64)base + size);
+
+        if(from < to)
+            memcpy(out.data() + (from - base), s.data.constData() + (from - s.address), to - from);
+    }
+
+    return out;
+}
@@ -0,0 +1,53 @@
+#ifndef SPARSEIMAGE_H
+#define SPARSEIMAGE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 地址连续的一段固件数据
+ */
+struct ImageSegment
+{
+    uint address;           /*!< 起始地址 */
+    QByteArray data;
+};
+
+/**
+ * @brief 带地址的固件, 由 Intel HEX, Motorola S-record 或 ELF 文件解析得到
+ * @note  只保存文件中实际存在的数据, 段按地址排序, 相邻或重叠的段已合并
+ */
+class SparseImage
+{
+public:
+    SparseImage();
+
+    static bool is_sparse_file(const QString &path);
+
+    bool load(const QString &path);
+    bool load_hex(const QByteArray &text);
+    bool load_srec(const QByteArray &text);
+    bool load_elf(const QByteArray &file);
+    void clear(void);
+
+    const QVector<ImageSegment> &segments(void) const { return segs; }
+    bool isEmpty(void) const { return segs.isEmpty(); }
+    uint start(void) const;
+    uint end(void) const;
+    qint64 data_size(void) const;
+    QString error_string(void) const { return error; }
+
+    void align(uint alignment, char fill);
+    QByteArray flatten(uint base, uint size, char fill) const;
+
+private:
+    QVector<ImageSegment> segs;
+    QString error;
+
+    void add(uint address, const char *data, int len);
+    void finish(void);
+    bool fail(const QString &msg, int line);
+};
+
+#endif // SPARSEIMAGE_H
@@ -0,0 +1,251 @@
+#include "tracebuffer.h"
+#include "protocol.h"
+#include <QFile>
+#include <QMap>
+#include <stdio.h>
+
+TraceBuffer::TraceBuffer()
+{
+    ring = NULL;
+    mask = 0;
+    head = 0;
+    next_id = 0;
+    reset_link();
+}
+
+/**
+* @brief  启用或停止跟踪, 并清空已记录的事件
+* @param  [in] capacity int. 保留的事件数, 向上取为 2 的幂. 为 0 时停止跟踪并释放缓冲区
+*/
+void TraceBuffer::enable(int capacity)
+{
+    uint size = 1;
+
+    if(capacity <= 0)
+    {
+        events.clear();
+        events.squeeze();
+        ring = NULL;
+        mask = 0;
+        return;
+    }
+
+    while((int)size < capacity)
+        size <<= 1;
+
+    events.resize(size);
+    ring = events.data();
+    mask = size - 1;
+    clear();
+}
+
+void TraceBuffer::clear(void)
+{
+    head = 0;
+    next_id = 0;
+    clock.start();
+    reset_link();
+}
+
+/**
+ * @brief 串口重新打开, 之前写入与等待应答的指令不再跟踪
+ */
+void TraceBuffer::reset_link(void)
+{
+    tx_head = 0;
+    tx_tail = 0;
+    tx_total = 0;
+    tx_done = 0;
+    rx_head = 0;
+    rx_tail = 0;
+    rx_started = false;
+}
+
+int TraceBuffer::count(void) const
+{
+    return (head > mask + 1) ? (int)(mask + 1) : (int)head;
+}
+
+/**
+ * @brief 串口写出了数据, 记录已全部写出的指令
+ * @param [in] bytes qint64. 本次写出的字节数
+ */
+void TraceBuffer::written(qint64 bytes)
+{
+    if(mask == 0)
+        return;
+
+    tx_done += bytes;
+    while((tx_tail != tx_head) && (tx[tx_tail % TRACE_PENDING_MAX].end <= tx_done))
+    {
+        const Pending &p = tx[tx_tail % TRACE_PENDING_MAX];
+        record(TRACE_WRITTEN, p.id, p.cmd, 0);
+        tx_tail++;
+    }
+}
+
+/**
+ * @brief 清空接收缓存后发送新的指令, 之前的指令不会再有应答
+ */
+void TraceBuffer::discard_replies(void)
+{
+    rx_tail = rx_head;
+    rx_started = false;
+}
+
+const char *TraceBuffer::cmd_name(int cmd)
+{
+    switch(cmd)
+    {
+    case PROTO_GET_SYNC:        return "GET_SYNC";
+    case PROTO_SET_BAUD:        return "SET_BAUD";
+    case PROTO_GET_UDID:        return "GET_UDID";
+    case PROTO_GET_FW_SIZE:     return "GET_FW_SIZE";
+    case PROTO_GET_BL_REV:      return "GET_BL_REV";
+    case PROTO_GET_ID:          return "GET_ID";
+    case PROTO_GET_SN:          return "GET_SN";
+    case PROTO_GET_REV:         return "GET_REV";
+    case PROTO_GET_FLASH_STRC:  return "GET_FLASH_STRC";
+    case PROTO_GET_DES:         return "GET_DES";
+    case PROTO_GET_CAPS:        return "GET_CAPS";
+    case PROTO_GET_FRAME_MAX:   return "GET_FRAME_MAX";
+    case PROTO_CHIP_ERASE:      return "CHIP_ERASE";
+    case PROTO_PROG_MULTI:      return "PROG_MULTI";
+    case PROTO_GET_CRC:         return "GET_CRC";
+    case PROTO_BOOT:            return "BOOT";
+    case PROTO_SECTOR_ERASE:    return "SECTOR_ERASE";
+    case PROTO_GET_RANGE_CRC:   return "GET_RANGE_CRC";
+    case PROTO_SET_PROG_ADDR:   return "SET_PROG_ADDR";
+    case PROTO_PROG_SKIP:       return "PROG_SKIP";
+    case PROTO_PROG_LZ:         return "PROG_LZ";
+    case PROTO_PROG_MULTI_EXT:  return "PROG_MULTI_EXT";
+    case PROTO_GET_PROG_ADDR:   return "GET_PROG_ADDR";
+    default:                    return "UNKNOWN";
+    }
+}
+
+/**
+* @brief  导出为 Chrome trace JSON
+* @note   阶段为线程 1 上的区间; 每条指令为线程 2 上的异步区间, 其下分为
+*         host (写入缓存到写出), link (写出到应答第一批数据), reply (应答第一批数据到解析完成) 三段
+* @param  [in] path QString. 文件路径
+* @param  [in] phase_name 阶段名称
+* @return 是否成功. 失败原因由 error_string 返回
+*/
+bool TraceBuffer::save_json(const QString &path, const char *(*phase_name)(int)) const
+{
+    static const char *segment_name[3] = {"host", "link", "reply"};
+    static const char *result_name[4] = {"timeout", "ok", "invalid", "failed"};
+
+    struct Span
+    {
+        int cmd;
+        int bytes;
+        int result;
+        qint64 t[4];                        /*!< 各 TRACE_* 事件的时刻, 未记录为 -1 */
+    };
+
+    QMap<int, Span> spans;
+    QByteArray out;
+    char line[256];
+    quint64 first = head - count();
+    int phase = -1;
+    qint64 phase_ts = 0;
+    qint64 last_ts = 0;
+
+    out.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    out.append("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"OrangeBoot\"}},\n");
+    out.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"phase\"}},\n");
+    out.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"commands\"}}");
+
+    for(quint64 i = first; i < head; i++)
+    {
+        const TraceEvent &e = ring[i & mask];
+
+        last_ts = e.ts;
+        if(e.kind == TRACE_STEP)
+        {
+            if(phase >= 0)
+            {
+                snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                         phase_name(phase), phase_ts / 1000.0, (e.ts - phase_ts) / 1000.0);
+                out.append(line);
+            }
+            phase = e.arg;
+            phase_ts = e.ts;
+            continue;
+        }
+
+        QMap<int, Span>::iterator it = spans.find(e.id);
+        if(it == spans.end())
+        {
+            Span s = {e.cmd, 0, -1, {-1, -1, -1, -1}};
+            it = spans.insert(e.id, s);
+        }
+
+        it->t[e.kind] = e.ts;
+        if(e.kind == TRACE_QUEUED)
+            it->bytes = e.arg;
+        else if(e.kind == TRACE_REPLY)
+            it->result = e.arg;
+    }
+
+    if(phase >= 0)
+    {
+        snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                 phase_name(phase), phase_ts / 1000.0, (last_ts - phase_ts) / 1000.0);
+        out.append(line);
+    }
+
+    for(QMap<int, Span>::const_iterator it = spans.constBegin(); it != spans.constEnd(); ++it)
+    {
+        const Span &s = it.value();
+        const char *name = cmd_name(s.cmd);
+        qint64 t[4];
+        qint64 begin = -1;
+        qint64 end = -1;
+
+        /* 写出与应答分别由 bytesWritten 与 readyRead 通知, 同一轮事件循环中的先后不确定, 按发生顺序修正 */
+        for(int k = 0; k < 4; k++)
+        {
+            t[k] = s.t[k];
+            if(t[k] < 0)
+                continue;
+            if(end > t[k])
+                t[k] = end;
+            if(begin < 0)
+                begin = t[k];
+            end = t[k];
+        }
+
+        snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"cmd\",\"ph\":\"b\",\"id\":%d,\"pid\":1,\"tid\":2,\"ts\":%.3f,\"args\":{\"bytes\":%d}}",
+                 name, it.key(), begin / 1000.0, s.bytes);
+        out.append(line);
+
+        for(int k = 0; k < 3; k++)
+        {
+            if((t[k] < 0) || (t[k + 1] < 0))
+                continue;
+
+            snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"cmd\",\"ph\":\"b\",\"id\":%d,\"pid\":1,\"tid\":2,\"ts\":%.3f}"
+                                         ",\n{\"name\":\"%s\",\"cat\":\"cmd\",\"ph\":\"e\",\"id\":%d,\"pid\":1,\"tid\":2,\"ts\":%.3f}",
+                     segment_name[k], it.key(), t[k] / 1000.0, segment_name[k], it.key(), t[k + 1] / 1000.0);
+            out.append(line);
+        }
+
+        snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"cmd\",\"ph\":\"e\",\"id\":%d,\"pid\":1,\"tid\":2,\"ts\":%.3f,\"args\":{\"result\":\"%s\"}}",
+                 name, it.key(), end / 1000.0, ((s.result >= 0) && (s.result < 4)) ? result_name[s.result] : "none");
+        out.append(line);
+    }
+
+    out.append("\n]}\n");
+
+    QFile f(path);
+    if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || (f.write(out) != out.size()))
+    {
+        error = f.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,163 @@
+#ifndef TRACEBUFFER_H
+#define TRACEBUFFER_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+#define TRACE_EVENTS_DEFAULT        (64 * 1024)     /*!< 默认保留的事件数, 超出后覆盖最早的事件 */
+#define TRACE_PENDING_MAX           256             /*!< 最多跟踪的未写出 / 未应答指令数, 不小于烧写窗口 */
+
+/**
+ * @brief 跟踪事件类型
+ */
+enum TraceKind
+{
+    TRACE_QUEUED = 0,       /*!< 指令写入串口缓存 */
+    TRACE_WRITTEN,          /*!< 指令的最后一个字节已交给系统驱动 */
+    TRACE_FIRST_BYTE,       /*!< 收到应答的第一批数据 */
+    TRACE_REPLY,            /*!< 应答解析完成 (或超时) */
+    TRACE_STEP              /*!< 引擎进入新的阶段 */
+};
+
+/**
+ * @brief 跟踪事件, 预先分配, 记录时不申请内存
+ */
+struct TraceEvent
+{
+    qint64 ts;              /*!< 时刻, 单位 ns */
+    int id;                 /*!< 指令序号, 同一条指令的各事件相同 */
+    short kind;             /*!< TRACE_* */
+    short cmd;              /*!< 指令 */
+    int arg;                /*!< 写入的字节数 / 应答结果 / 阶段 */
+};
+
+/**
+ * @brief 指令收发跟踪
+ * @note  每条指令记录 写入缓存 -> 写出 -> 应答第一批数据 -> 应答解析完成 四个时刻, 分别对应
+ *        主机端排队, 串口适配器与设备处理, 应答传输三段. 事件存放在预先分配的环形缓冲区中,
+ *        未启用时每次记录只有一次判断. 可导出为 Chrome trace JSON (chrome://tracing, Perfetto)
+ */
+class TraceBuffer
+{
+public:
+    TraceBuffer();
+
+    void enable(int capacity);
+    bool enabled(void) const { return mask != 0; }
+    void clear(void);
+    void reset_link(void);
+    int count(void) const;
+
+    /**
+     * @brief 指令写入串口缓存, 应答按写入顺序对应
+     * @param [in] cmd int. 指令
+     * @param [in] bytes int. 写入的字节数
+     */
+    inline void queued(int cmd, int bytes)
+    {
+        if(mask == 0)
+            return;
+
+        int id = next_id++;
+
+        record(TRACE_QUEUED, id, cmd, bytes);
+
+        if(tx_head - tx_tail >= TRACE_PENDING_MAX)
+            tx_tail++;
+        tx_total += bytes;
+        tx[tx_head % TRACE_PENDING_MAX].id = id;
+        tx[tx_head % TRACE_PENDING_MAX].cmd = cmd;
+        tx[tx_head % TRACE_PENDING_MAX].end = tx_total;
+        tx_head++;
+
+        if(rx_head - rx_tail >= TRACE_PENDING_MAX)
+            rx_tail++;
+        rx[rx_head % TRACE_PENDING_MAX].id = id;
+        rx[rx_head % TRACE_PENDING_MAX].cmd = cmd;
+        rx_head++;
+    }
+
+    /**
+     * @brief 收到数据, 是当前应答的第一批数据时记录
+     */
+    inline void reply_data(void)
+    {
+        if((mask == 0) || rx_started || (rx_head == rx_tail))
+            return;
+
+        rx_started = true;
+        record(TRACE_FIRST_BYTE, rx[rx_tail % TRACE_PENDING_MAX].id, rx[rx_tail % TRACE_PENDING_MAX].cmd, 0);
+    }
+
+    /**
+     * @brief 当前应答解析完成或超时
+     * @param [in] result int. 应答结果
+     */
+    inline void reply(int result)
+    {
+        if((mask == 0) || (rx_head == rx_tail))
+            return;
+
+        rx_started = false;
+        record(TRACE_REPLY, rx[rx_tail % TRACE_PENDING_MAX].id, rx[rx_tail % TRACE_PENDING_MAX].cmd, result);
+        rx_tail++;
+    }
+
+    /**
+     * @brief 进入新的阶段
+     * @param [in] phase int. 阶段, 小于 0 为空闲
+     */
+    inline void step(int phase)
+    {
+        if(mask != 0)
+            record(TRACE_STEP, -1, 0, phase);
+    }
+
+    void written(qint64 bytes);
+    void discard_replies(void);
+
+    bool save_json(const QString &path, const char *(*phase_name)(int)) const;
+    QString error_string(void) const { return error; }
+
+private:
+    QVector<TraceEvent> events;
+    TraceEvent *ring;                       /*!< events 的数据, 记录时不经过 QVector 的共享检查 */
+    uint mask;                              /*!< 容量 - 1, 为 0 时未启用 */
+    quint64 head;                           /*!< 已记录的事件总数 */
+    QElapsedTimer clock;
+    int next_id;
+
+    struct Pending
+    {
+        int id;
+        int cmd;
+        qint64 end;                         /*!< 写出此指令后累计写出的字节数 */
+    };
+    Pending tx[TRACE_PENDING_MAX];          /*!< 尚未写出的指令 */
+    uint tx_head;
+    uint tx_tail;
+    qint64 tx_total;                        /*!< 累计写入缓存的字节数 */
+    qint64 tx_done;                         /*!< 累计写出的字节数 */
+    Pending rx[TRACE_PENDING_MAX];          /*!< 尚未应答的指令 */
+    uint rx_head;
+    uint rx_tail;
+    bool rx_started;                        /*!< 当前应答已收到部分数据 */
+    mutable QString error;
+
+    inline void record(int kind, int id, int cmd, int arg)
+    {
+        TraceEvent &e = ring[head & mask];
+
+        e.ts = clock.nsecsElapsed();
+        e.id = id;
+        e.kind = kind;
+        e.cmd = cmd;
+        e.arg = arg;
+        head++;
+    }
+
+    static const char *cmd_name(int cmd);
+};
+
+#endif // TRACEBUFFER_H
@@ -0,0 +1,142 @@
+#include "udidstore.h"
+#include <QCoreApplication>
+#include <QSettings>
+
+/**
+ * @brief 构造
+ * @param [in] settings QSettings*. 已打开的 config.ini
+ * @param [in] group_name QString. 组名
+ * @param [in] fields int. 每条记录的字段数量, 不含序号
+ * @param [in] max int. 保留的记录数量
+ */
+UdidStore::UdidStore(QSettings *settings, const QString &group_name, int fields, int max)
+{
+    ini = settings;
+    group = group_name;
+    field_num = fields;
+    max_num = max;
+}
+
+/**
+ * @brief 程序目录下的 config.ini
+ */
+QString UdidStore::file(void)
+{
+    return QCoreApplication::applicationDirPath() + "/config.ini";
+}
+
+QString UdidStore::key(const QByteArray &udid) const
+{
+    return "/" + group + "/udid_" + QString::fromLatin1(udid.toHex());
+}
+
+/**
+ * @brief 读取一条记录
+ * @return 是否存在且格式正确
+ */
+bool UdidStore::read_key(const QString &name, QStringList *fields, int *seq) const
+{
+    QStringList list = ini->value(name).toString().split(',');
+
+    if(list.count() != field_num + 1)
+        return false;
+
+    *seq = list.takeLast().toInt();
+    *fields = list;
+    return true;
+}
+
+/**
+* @brief  读取设备记录
+* @param  [in] udid QByteArray. 设备 UDID
+* @param  [out] fields QStringList*. 记录的字段, 不含序号
+* @return 是否存在
+*/
+bool UdidStore::read(const QByteArray &udid, QStringList *fields) const
+{
+    int seq;
+
+    if(udid.isEmpty())
+        return false;
+
+    return read_key(key(udid), fields, &seq);
+}
+
+/**
+ * @brief 写入设备记录
+ * @param [in] touch bool. 是否更新最近使用序号, 为 false 时只修改字段, 不影响删除顺序
+ */
+void UdidStore::write(const QByteArray &udid, const QStringList &fields, bool touch)
+{
+    QStringList old;
+    int seq = 0;
+
+    if(udid.isEmpty())
+        return;
+
+    if(touch || !read_key(key(udid), &old, &seq))
+        seq = next_seq();
+
+    ini->setValue(key(udid), fields.join(',') + "," + QString::number(seq));
+    evict();
+}
+
+void UdidStore::remove(const QByteArray &udid)
+{
+    if(udid.isEmpty())
+        return;
+
+    ini->remove(key(udid));
+}
+
+/**
+ * @brief 组内的下一个序号, 组内其他记录 (如串口记录) 也可使用
+ */
+int UdidStore::next_seq(void)
+{
+    int seq = ini->value("/" + group + "/seq", 0).toInt() + 1;
+
+    ini->setValue("/" + group + "/seq", seq);
+    return seq;
+}
+
+/**
+ * @brief 所有设备的 UDID, 最近使用的在前
+ */
+QList<QByteArray> UdidStore::udids(void) const
+{
+    QList<QByteArray> result;
+    QList<int> result_seq;
+
+    ini->beginGroup(group);
+    QStringList keys = ini->childKeys();
+    ini->endGroup();
+
+    for(int i = 0; i < keys.count(); i++)
+    {
+        QStringList fields;
+        int seq;
+
+        if(!keys.at(i).startsWith("udid_") || !read_key("/" + group + "/" + keys.at(i), &fields, &seq))
+            continue;
+
+        int pos = 0;
+        while((pos < result_seq.size()) && (result_seq.at(pos) > seq))
+            pos++;
+        result.insert(pos, QByteArray::fromHex(keys.at(i).mid(5).toLatin1()));
+        result_seq.insert(pos, seq);
+    }
+
+    return result;
+}
+
+/**
+ * @brief 记录数量超过上限时删除最久未使用的
+ */
+void UdidStore::evict(void)
+{
+    QList<QByteArray> list = udids();
+
+    while(list.size() > max_num)
+        remove(list.takeLast());
+}
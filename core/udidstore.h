@@ -0,0 +1,40 @@
+#ifndef UDIDSTORE_H
+#define UDIDSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+
+class QSettings;
+
+/**
+ * @brief 按设备 UDID 保存的记录
+ * @note  记录保存在 config.ini 中指定组下, 键为 udid_ 加 UDID 的十六进制, 值为逗号分隔的字段, 最后一个字段为
+ *        最近使用序号. 记录数量超过上限时删除最久未使用的. 本类不加锁, 由调用者保证同一时间只有一个线程访问
+ */
+class UdidStore
+{
+public:
+    UdidStore(QSettings *settings, const QString &group_name, int fields, int max);
+
+    bool read(const QByteArray &udid, QStringList *fields) const;
+    void write(const QByteArray &udid, const QStringList &fields, bool touch = true);
+    void remove(const QByteArray &udid);
+    QList<QByteArray> udids(void) const;
+    int next_seq(void);
+
+    static QString file(void);
+
+private:
+    QString key(const QByteArray &udid) const;
+    bool read_key(const QString &name, QStringList *fields, int *seq) const;
+    void evict(void);
+
+    QSettings *ini;
+    QString group;
+    int field_num;                  /*!< 不含序号的字段数量 */
+    int max_num;
+};
+
+#endif // UDIDSTORE_H
@@ -0,0 +1,102 @@
+#include "flashlayoutmodel.h"
+
+FlashLayoutModel::FlashLayoutModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+}
+
+void FlashLayoutModel::set_layout(const FlashLayout &layout)
+{
+    beginResetModel();
+    this->layout = layout;
+    endResetModel();
+}
+
+void FlashLayoutModel::clear(void)
+{
+    beginResetModel();
+    layout.clear();
+    endResetModel();
+}
+
+int FlashLayoutModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : layout.size();
+}
+
+int FlashLayoutModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COL_NUM_MAX;
+}
+
+QVariant FlashLayoutModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || (index.row() >= layout.size()))
+        return QVariant();
+
+    const FlashSector &s = layout.at(index.row());
+    int perm = 0;
+
+    switch(index.column())
+    {
+    case COL_READ:
+        perm = FLASH_PERM_READ;
+        break;
+    case COL_WRITE:
+        perm = FLASH_PERM_WRITE;
+        break;
+    case COL_ERASE:
+        perm = FLASH_PERM_ERASE;
+        break;
+    default:
+        break;
+    }
+
+    if(role == Qt::TextAlignmentRole)
+        return perm ? QVariant(int(Qt::AlignCenter)) : QVariant();
+
+    if(role != Qt::DisplayRole)
+        return QVariant();
+
+    switch(index.column())
+    {
+    case COL_NUM:
+        return QString::number(index.row(), 10);
+    case COL_START:
+        return "0x" + QString("%1").arg(s.address, 8, 16, QChar('0'));
+    case COL_END:
+        return "0x" + QString("%1").arg(s.address + s.size, 8, 16, QChar('0'));
+    case COL_SIZE:
+        if(s.size % 1024)
+            return QString::number(s.size, 10) + " b";
+        return QString::number(s.size / 1024, 10) + " kb";
+    default:
+        return (s.perm & perm) ? QVariant("X") : QVariant();
+    }
+}
+
+QVariant FlashLayoutModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if((orientation != Qt::Horizontal) || (role != Qt::DisplayRole))
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    switch(section)
+    {
+    case COL_NUM:
+        return tr("Sector Num");
+    case COL_START:
+        return tr("Start Address");
+    case COL_END:
+        return tr("End Address");
+    case COL_SIZE:
+        return tr("Size");
+    case COL_READ:
+        return tr("Readable");
+    case COL_WRITE:
+        return tr("Writeable");
+    case COL_ERASE:
+        return tr("Erasable");
+    default:
+        return QVariant();
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef FLASHLAYOUTMODEL_H
+#define FLASHLAYOUTMODEL_H
+
+#include <QAbstractTableModel>
+#include "flashlayout.h"
+
+/**
+ * @brief 扇区表数据模型
+ * @note  只保存 FlashLayout, 单元格内容在视图需要显示时才生成,
+ *        扇区数量很多时也不会为每个单元格分配对象
+ */
+class FlashLayoutModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 表格列
+     */
+    enum Column
+    {
+        COL_NUM = 0,        /*!< 扇区序号 */
+        COL_START,          /*!< 起始地址 */
+        COL_END,            /*!< 结束地址 */
+        COL_SIZE,           /*!< 大小 */
+        COL_READ,           /*!< 可读 */
+        COL_WRITE,          /*!< 可写 */
+        COL_ERASE,          /*!< 可擦除 */
+        COL_NUM_MAX
+    };
+
+    explicit FlashLayoutModel(QObject *parent = 0);
+
+    void set_layout(const FlashLayout &layout);
+    void clear(void);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    FlashLayout layout;
+};
+
+#endif // FLASHLAYOUTMODEL_H
@@ -0,0 +1,406 @@
+#include "mainwindow.h"
+#include "ui_mainwindow.h"
+#include <QFileDialog>
+#include <qdebug.h>
+#include <QMessageBox>
+#include <stdio.h>
+#include <QFileInfo>
+#include "multiflashdialog.h"
+
+MainWindow::MainWindow(QWidget *parent) :
+    QMainWindow(parent),
+    ui(new Ui::MainWindow)
+{
+    ui->setupUi(this);
+
+    /* 表格控件初始化设置 */
+    model = new FlashLayoutModel(this);
+    ui->tableView->setModel(model);                            /* 绑定数据模型 */
+
+    ui->tableView->setColumnWidth(0, 100);                                        /* 设定行宽 */
+    ui->tableView->setColumnWidth(1, 100);
+    ui->tableView->setColumnWidth(2, 100);
+    ui->tableView->setColumnWidth(3, 100);
+    ui->tableView->setColumnWidth(4, 100);
+    ui->tableView->setColumnWidth(5, 80);
+    ui->tableView->setColumnWidth(6, 80);
+    ui->tableView->setColumnWidth(7, 80);
+    ui->tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);  /* 固定行宽 */
+    ui->tableView->verticalHeader()->setDefaultSectionSize(20);                   /* 设定行高 */
+    ui->tableView->verticalHeader()->hide();                                      /* 关闭列头显示 */
+    ui->tableView->horizontalHeader()->setStretchLastSection(true);               /* 列末尾对齐 */
+    ui->tableView->setEditTriggers ( QAbstractItemView::NoEditTriggers );         /* 禁止调整宽度 */
+    ui->tableView->setSelectionBehavior(QAbstractItemView::SelectRows);           /* 选择时选中一行 */
+    ui->tableView->setSelectionMode ( QAbstractItemView::SingleSelection);        /* 只能同时选择遗憾数据 */
+
+    /* 连接设备前禁止功能按键 */
+    ui->pushButton_2->setEnabled(false);
+    ui->pushButton_3->setEnabled(false);
+    ui->pushButton_5->setEnabled(false);
+
+    /* 烧写引擎运行于独立线程, 独占串口 */
+    engine = new FlashEngine();
+    engine_thread = new QThread(this);
+    engine->moveToThread(engine_thread);
+    connect(engine_thread, &QThread::finished, engine, &QObject::deleteLater);
+
+    connect(this, &MainWindow::request_open, engine, &FlashEngine::open_device);
+    connect(this, &MainWindow::request_close, engine, &FlashEngine::close_device);
+    connect(this, &MainWindow::request_erase, engine, &FlashEngine::erase);
+    connect(this, &MainWindow::request_program_file, engine, &FlashEngine::program_file);
+    connect(this, &MainWindow::request_update_file, engine, &FlashEngine::update_file);
+    connect(this, &MainWindow::request_boot, engine, &FlashEngine::boot);
+    connect(this, &MainWindow::request_prog_window, engine, &FlashEngine::set_prog_window);
+    connect(this, &MainWindow::request_max_frame, engine, &FlashEngine::set_max_frame);
+    connect(this, &MainWindow::request_max_baud, engine, &FlashEngine::set_max_baudrate);
+    connect(this, &MainWindow::request_skip_blank, engine, &FlashEngine::set_skip_blank);
+    connect(this, &MainWindow::request_compress, engine, &FlashEngine::set_compress);
+    connect(this, &MainWindow::request_resume, engine, &FlashEngine::set_resume);
+
+    connect(engine, &FlashEngine::device_ready, this, &MainWindow::engine_device_ready);
+    connect(engine, &FlashEngine::device_closed, this, &MainWindow::engine_device_closed);
+    connect(engine, &FlashEngine::progress, this, &MainWindow::engine_progress);
+    connect(engine, &FlashEngine::warning, this, &MainWindow::engine_warning);
+    connect(engine, &FlashEngine::finished, this, &MainWindow::engine_finished);
+
+    engine_thread->start();
+    scan_serial_port();                                /* 开启软件后直接执行一次串口扫描操作 */
+
+    /* 由于comboBox没有鼠标点击的slot，所以使用事件过滤器来对点击操作进行响应 */
+    ui->comboBox->installEventFilter(this);
+
+    /* comboBox2 加入数据 */
+    ui->comboBox_2->addItem("Auto");
+    ui->comboBox_2->addItem("256000");
+    ui->comboBox_2->addItem("115200");
+    ui->comboBox_2->addItem("57600");
+    ui->comboBox_2->addItem("38400");
+    ui->comboBox_2->addItem("19200");
+    ui->comboBox_2->addItem("14400");
+    ui->comboBox_2->addItem("9600");
+
+    /* 进度条归零 */
+    ui->progressBar->setValue(0);
+
+    /* 如果配置文件存在，则加载固件路径 */
+    QFileInfo file(QCoreApplication::applicationDirPath() + "/config.ini");
+    if(file.exists() == true)
+    {
+        QSettings *pIni = new QSettings(QCoreApplication::applicationDirPath() + "/config.ini", QSettings::IniFormat);
+        QString file_path_log = pIni->value("/Log/FilePath").toString();
+        delete pIni;
+
+        ui->textEdit->setText(file_path_log);
+    }
+
+    /* 烧写滑动窗口大小, 可在配置文件 /Program/Window 中修改, 设为 1 时退化为逐帧应答 */
+    /* 数据帧长度上限, 可在配置文件 /Program/MaxFrame 中修改, 设为 0 时使用设备报告的长度 */
+    /* 增量烧写, 可在配置文件 /Program/Incremental 中开启, 只擦写与固件不一致的扇区 */
+    /* 同步后协商的最高波特率, 可在配置文件 /Connect/MaxBaud 中修改, 设为 0 时不切换 */
+    /* 跳过全为 0xFF 的帧, 可在配置文件 /Program/SkipBlank 中关闭 */
+    /* 设备支持时发送压缩帧, 可在配置文件 /Program/Compress 中关闭 */
+    /* 整片烧写中断后从断点继续, 可在配置文件 /Program/Resume 中关闭 */
+    prog_window = PROG_WINDOW_DEFAULT;
+    max_frame = 0;
+    prog_incremental = false;
+    max_baud = MAX_BAUD_DEFAULT;
+    skip_blank = true;
+    compress = true;
+    resume = true;
+    if(file.exists() == true)
+    {
+        QSettings *pIni = new QSettings(QCoreApplication::applicationDirPath() + "/config.ini", QSettings::IniFormat);
+        prog_window = pIni->value("/Program/Window", PROG_WINDOW_DEFAULT).toInt();
+        max_frame = pIni->value("/Program/MaxFrame", 0).toInt();
+        prog_incremental = pIni->value("/Program/Incremental", false).toBool();
+        max_baud = pIni->value("/Connect/MaxBaud", MAX_BAUD_DEFAULT).toInt();
+        skip_blank = pIni->value("/Program/SkipBlank", true).toBool();
+        compress = pIni->value("/Program/Compress", true).toBool();
+        resume = pIni->value("/Program/Resume", true).toBool();
+        delete pIni;
+    }
+    emit request_prog_window(prog_window);
+    emit request_max_frame(max_frame);
+    emit request_max_baud(max_baud);
+    emit request_skip_blank(skip_blank);
+    emit request_compress(compress);
+    emit request_resume(resume);
+}
+
+MainWindow::~MainWindow()
+{
+    /* 在工作线程中关闭串口后再退出线程 */
+    QMetaObject::invokeMethod(engine, "close_device", Qt::BlockingQueuedConnection);
+    engine_thread->quit();
+    engine_thread->wait();
+
+    delete ui;
+}
+
+/**
+ * @brief 选择固件按钮点击事件
+*/
+void MainWindow::on_pushButton_clicked()
+{
+    QFileDialog *fileDialog = new QFileDialog(this);
+    fileDialog->setWindowTitle(tr("选择固件"));
+    fileDialog->setDirectory(".");
+    fileDialog->setNameFilters(QStringList() << tr("固件(*.bin *.hex *.ihx *.ihex *.s19 *.s28 *.s37 *.srec *.mot *.elf *.axf *.out)")
+                                             << tr("Bin(*.bin)")
+                                             << tr("Intel HEX(*.hex *.ihx *.ihex)")
+                                             << tr("S-record(*.s19 *.s28 *.s37 *.srec *.mot)")
+                                             << tr("ELF(*.elf *.axf *.out)"));
+    fileDialog->setFileMode(QFileDialog::ExistingFiles);
+    fileDialog->setViewMode(QFileDialog::Detail);
+
+    if(fileDialog->exec() == QDialog::Accepted)
+    {
+        QString fileNames = fileDialog->selectedFiles()[0];
+        if(!fileNames.isEmpty())
+        {
+            ui->textEdit->setText(fileNames);
+            qDebug()<<fileNames<<endl;
+
+            // 建立ini配置文件记录bin固件
+            QSettings *configIniWrite = new QSettings(QCoreApplication::applicationDirPath() + "/config.ini", QSettings::IniFormat);
+            configIniWrite->setValue("/Log/FilePath", fileNames);
+            delete configIniWrite;
+        }
+    }
+}
+
+/**
+ * @brief 对鼠标点击comboBox事件的处理
+*/
+bool MainWindow::eventFilter(QObject *f_object, QEvent *f_event)
+{
+    /* 鼠标点击comboBox事件. 操作：刷新串口列表 */
+    if(f_object == ui->comboBox)
+    {
+        if(f_event->type() == QEvent::MouseButtonPress)
+        {
+            scan_serial_port();
+        }
+        return false;
+    }
+    return false;
+}
+
+/**
+ * @brief 扫描可使用的串口并添加到combox中
+ */
+void MainWindow::scan_serial_port(void)
+{
+    QStringList new_portlist;
+    QStringList current_portlist;
+
+    /* 该函数会根据系统串口数量循环，每次检出一个串口信息 */
+    foreach(const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
+    {
+        QSerialPort serial;
+        serial.setPort(info);
+        new_portlist << serial.portName();
+    }
+
+    /* 读取当前combox内容 */
+    for(int i = 0; i < ui->comboBox->count(); i++)
+    {
+        current_portlist += ui->comboBox->itemText(i);
+    }
+
+    /* 添加新出现的串口号 */
+    for(int i = 0; i < new_portlist.size(); i++)
+    {
+        /* 如果当前combox中不包含有new_portlist中的内容则 */
+        if(!current_portlist.contains(new_portlist.at(i)))
+        {
+            ui->comboBox->addItem(new_portlist.at(i));
+        }
+    }
+
+    /* 删除消失的串口号 */
+    for(int i = 0; i < current_portlist.size(); i++)
+    {
+        /* 如果new_portlist中不包含有当前combox中的内容则 */
+        if(!new_portlist.contains(current_portlist.at(i)))
+        {
+            ui->comboBox->removeItem(i);
+        }
+    }
+}
+
+/**
+ * @brief 锁定/解锁功能按键
+ * @param [in] connected bool. 设备是否已连接, 未连接时仅开放连接按键
+*/
+void MainWindow::set_buttons(bool connected)
+{
+    ui->pushButton_2->setEnabled(connected);
+    ui->pushButton_3->setEnabled(connected);
+    ui->pushButton_5->setEnabled(connected);
+    ui->pushButton_7->setEnabled(true);
+}
+
+void MainWindow::lock_buttons(void)
+{
+    ui->pushButton_2->setEnabled(false);
+    ui->pushButton_3->setEnabled(false);
+    ui->pushButton_5->setEnabled(false);
+    ui->pushButton_7->setEnabled(false);
+}
+
+/**
+ * @brief 连接/断开设备按钮
+ */
+void MainWindow::on_pushButton_7_clicked()
+{
+    if(ui->pushButton_7->text() == tr("连接设备"))
+    {
+        /* 如果串口列表选择非空 */
+        if(ui->comboBox->currentText().isEmpty())
+            return;
+
+        int baudrate = 0;
+        if(ui->comboBox_2->currentText() != "Auto")
+            baudrate = ui->comboBox_2->currentText().toInt();
+
+        lock_buttons();
+        emit request_open(ui->comboBox->currentText(), baudrate);
+    }
+    else
+    {
+        emit request_close();
+    }
+}
+
+/**
+ * @brief 擦除APP按键点击事件
+*/
+void MainWindow::on_pushButton_2_clicked()
+{
+    // 锁定按键
+    lock_buttons();
+
+    emit request_erase();
+}
+
+/**
+ * @brief 烧写固件按钮点击事件
+*/
+void MainWindow::on_pushButton_3_clicked()
+{
+    lock_buttons();
+
+    /* 固件文件由引擎映射到内存, 整片烧写时先开始擦除再计算CRC */
+    if(prog_incremental)
+        emit request_update_file(ui->textEdit->toPlainText());
+    else
+        emit request_program_file(ui->textEdit->toPlainText());
+}
+
+/**
+ * @brief 批量烧写按钮点击事件, 使用当前固件路径与波特率设置
+*/
+void MainWindow::on_pushButton_4_clicked()
+{
+    int baudrate = 0;
+    if(ui->comboBox_2->currentText() != "Auto")
+        baudrate = ui->comboBox_2->currentText().toInt();
+
+    MultiFlashDialog *dialog = new MultiFlashDialog(ui->textEdit->toPlainText(), baudrate, prog_window, max_baud,
+                                                    max_frame, skip_blank, compress, resume, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::on_pushButton_5_clicked()
+{
+    lock_buttons();
+
+    emit request_boot();
+}
+
+/**
+ * @brief 显示设备信息
+ * @param [in] info DeviceInfo. 设备信息, 不支持的项为空
+*/
+void MainWindow::engine_device_ready(DeviceInfo info)
+{
+    if(!info.udid.isEmpty())
+    {
+        QByteArray udid = info.udid;
+        QByteArray revert;
+        revert.resize(12);
+
+        for(int i = 0; i < 12; i++)
+            revert[i] = udid[12 - i];
+
+        ui->textEdit_2->setText(revert.mid(0,12).toHex().toUpper());
+    }
+
+    if(info.fw_size > 0)
+        ui->textEdit_3->setText(QString::number(info.fw_size / 1024, 10) + "KB");
+
+    ui->textEdit_4->setText(info.bl_rev);
+    ui->textEdit_5->setText(QString::fromLocal8Bit(info.id));
+    ui->textEdit_6->setText(info.sn);
+    ui->textEdit_7->setText(info.rev);
+    ui->textEdit_8->setText(info.des);
+
+    qDebug() << info.flash_strc;
+    model->set_layout(info.layout);
+}
+
+/**
+ * @brief 串口关闭后清空设备信息
+*/
+void MainWindow::engine_device_closed(void)
+{
+    ui->pushButton_7->setText("连接设备");
+    set_buttons(false);
+
+    ui->textEdit_2->setText("");
+    ui->textEdit_3->setText("");
+    ui->textEdit_4->setText("");
+    ui->textEdit_5->setText("");
+    ui->textEdit_6->setText("");
+    ui->textEdit_7->setText("");
+    ui->textEdit_8->setText("");
+    model->clear();
+
+    qDebug()<<"串口已关闭";
+}
+
+void MainWindow::engine_progress(int value, int max)
+{
+    ui->progressBar->setRange(0, max);
+    ui->progressBar->setValue(value);
+}
+
+void MainWindow::engine_warning(QString msg)
+{
+    QMessageBox::critical(this, "错误提示", msg, QMessageBox::Ok);
+}
+
+/**
+ * @brief 引擎操作结束, 解锁按键并提示错误
+*/
+void MainWindow::engine_finished(int op, bool ok, QString msg)
+{
+    if(op == FlashEngine::OP_CONNECT)
+    {
+        if(ok)
+        {
+            ui->pushButton_7->setText("断开连接");
+            qDebug()<<"串口已开启";
+        }
+        set_buttons(ok);
+    }
+    else if(op != FlashEngine::OP_BOOT || !ok)
+    {
+        set_buttons(ui->pushButton_7->text() != tr("连接设备"));
+    }
+
+    if(!ok && !msg.isEmpty())
+        QMessageBox::critical(this, "错误提示", msg, QMessageBox::Ok);
+}
@@ -0,0 +1,71 @@
+#ifndef MAINWINDOW_H
+#define MAINWINDOW_H
+
+#include <QMainWindow>
+#include <QtSerialPort>
+#include <QThread>
+#include "flashengine.h"
+#include "flashlayoutmodel.h"
+
+namespace Ui {
+class MainWindow;
+}
+
+class MainWindow : public QMainWindow
+{
+    Q_OBJECT
+
+public:
+    explicit MainWindow(QWidget *parent = 0);
+    ~MainWindow();
+
+signals:
+    void request_open(QString port_name, int baudrate);
+    void request_close(void);
+    void request_erase(void);
+    void request_program_file(QString path);
+    void request_update_file(QString path);
+    void request_boot(void);
+    void request_prog_window(int window);
+    void request_max_frame(int bytes);
+    void request_max_baud(int baudrate);
+    void request_skip_blank(bool enable);
+    void request_compress(bool enable);
+    void request_resume(bool enable);
+
+private slots:
+    void on_pushButton_clicked();
+    void on_pushButton_7_clicked();
+    void on_pushButton_2_clicked();
+    void on_pushButton_3_clicked();
+    void on_pushButton_4_clicked();
+    void on_pushButton_5_clicked();
+
+    void engine_device_ready(DeviceInfo info);
+    void engine_device_closed(void);
+    void engine_progress(int value, int max);
+    void engine_warning(QString msg);
+    void engine_finished(int op, bool ok, QString msg);
+
+private:
+    Ui::MainWindow *ui;
+    FlashEngine *engine;
+    QThread *engine_thread;
+    int prog_window;
+    int max_frame;
+    bool prog_incremental;
+    int max_baud;
+    bool skip_blank;
+    bool compress;
+    bool resume;
+
+    FlashLayoutModel *model;
+
+    void scan_serial_port(void);
+    bool eventFilter(QObject *f_object, QEvent *f_event);
+
+    void set_buttons(bool connected);
+    void lock_buttons(void);
+};
+
+#endif // MAINWINDOW_H
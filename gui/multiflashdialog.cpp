@@ -0,0 +1,207 @@
+#include "multiflashdialog.h"
+#include "ui_multiflashdialog.h"
+#include "sparseimage.h"
+#include <QtSerialPort>
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QCloseEvent>
+
+MultiFlashDialog::MultiFlashDialog(QString file_path, int baudrate, int window, int max_baud,
+                                   int max_frame, bool skip_blank, bool compress, bool resume, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::MultiFlashDialog)
+{
+    ui->setupUi(this);
+
+    this->file_path = file_path;
+    this->baudrate = baudrate;
+    this->window = window;
+
+    /* 表格控件初始化设置 */
+    ui->tableWidget->setColumnCount(4);
+    ui->tableWidget->setHorizontalHeaderLabels(QStringList() << tr("串口") << tr("状态") << tr("进度") << tr("用时"));
+    ui->tableWidget->setColumnWidth(0, 80);
+    ui->tableWidget->setColumnWidth(1, 140);
+    ui->tableWidget->setColumnWidth(2, 140);
+    ui->tableWidget->verticalHeader()->hide();                                    /* 关闭列头显示 */
+    ui->tableWidget->horizontalHeader()->setStretchLastSection(true);             /* 列末尾对齐 */
+    ui->tableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);          /* 禁止编辑 */
+    ui->tableWidget->setSelectionMode(QAbstractItemView::NoSelection);
+
+    ui->pushButton_3->setEnabled(false);
+
+    flasher = new MultiFlasher(this);
+    flasher->set_max_baudrate(max_baud);
+    flasher->set_max_frame(max_frame);
+    flasher->set_skip_blank(skip_blank);
+    flasher->set_compress(compress);
+    flasher->set_resume(resume);
+    connect(flasher, &MultiFlasher::session_state, this, &MultiFlashDialog::flasher_state);
+    connect(flasher, &MultiFlasher::session_progress, this, &MultiFlashDialog::flasher_progress);
+    connect(flasher, &MultiFlasher::session_finished, this, &MultiFlashDialog::flasher_session_finished);
+    connect(flasher, &MultiFlasher::all_finished, this, &MultiFlashDialog::flasher_all_finished);
+
+    scan_serial_port();
+}
+
+MultiFlashDialog::~MultiFlashDialog()
+{
+    delete ui;
+}
+
+/**
+ * @brief 扫描可使用的串口, 以可勾选的方式列出
+ */
+void MultiFlashDialog::scan_serial_port(void)
+{
+    ui->listWidget->clear();
+
+    foreach(const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
+    {
+        QListWidgetItem *item = new QListWidgetItem(info.portName(), ui->listWidget);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Unchecked);
+    }
+}
+
+/**
+ * @brief 刷新串口按钮
+*/
+void MultiFlashDialog::on_pushButton_clicked()
+{
+    if(!flasher->is_running())
+        scan_serial_port();
+}
+
+/**
+ * @brief 开始烧写按钮, 固件只读取一次, 所有串口共用
+*/
+void MultiFlashDialog::on_pushButton_2_clicked()
+{
+    QStringList ports;
+    for(int i = 0; i < ui->listWidget->count(); i++)
+    {
+        if(ui->listWidget->item(i)->checkState() == Qt::Checked)
+            ports << ui->listWidget->item(i)->text();
+    }
+
+    if(ports.isEmpty())
+    {
+        QMessageBox::critical(this, "错误提示", "未选择串口", QMessageBox::Ok);
+        return;
+    }
+
+    /* 各设备的固件区地址可能不同, 带地址的固件只支持单设备烧写 */
+    if(SparseImage::is_sparse_file(file_path))
+    {
+        QMessageBox::critical(this, "错误提示", "多设备烧写只支持bin文件", QMessageBox::Ok);
+        return;
+    }
+
+    FirmwareImage image;
+    if(!image.open(file_path))
+    {
+        QMessageBox::critical(this, "错误提示", image.error_string(), QMessageBox::Ok);
+        return;
+    }
+
+    ui->tableWidget->setRowCount(ports.size());
+    for(int i = 0; i < ports.size(); i++)
+    {
+        ui->tableWidget->setItem(i, 0, new QTableWidgetItem(ports.at(i)));
+        ui->tableWidget->setItem(i, 1, new QTableWidgetItem(""));
+        ui->tableWidget->setItem(i, 3, new QTableWidgetItem(""));
+
+        QProgressBar *bar = new QProgressBar();
+        bar->setValue(0);
+        bar->setAlignment(Qt::AlignCenter);
+        ui->tableWidget->setCellWidget(i, 2, bar);
+    }
+
+    ui->label_2->setText("");
+    ui->pushButton->setEnabled(false);
+    ui->pushButton_2->setEnabled(false);
+    ui->pushButton_3->setEnabled(true);
+    ui->listWidget->setEnabled(false);
+
+    flasher->start(ports, baudrate, image, window, ui->checkBox->isChecked());
+}
+
+/**
+ * @brief 停止按钮
+*/
+void MultiFlashDialog::on_pushButton_3_clicked()
+{
+    flasher->stop();
+}
+
+void MultiFlashDialog::flasher_state(int index, int state, QString msg)
+{
+    QString text;
+
+    switch(state)
+    {
+    case MultiFlasher::ST_CONNECT:
+        text = "连接中";
+        break;
+    case MultiFlasher::ST_PROGRAM:
+        text = "烧写中";
+        break;
+    case MultiFlasher::ST_BOOT:
+        text = "启动中";
+        break;
+    case MultiFlasher::ST_DONE:
+        text = "完成";
+        break;
+    case MultiFlasher::ST_FAILED:
+        text = "失败: " + msg;
+        break;
+    default:
+        break;
+    }
+
+    ui->tableWidget->item(index, 1)->setText(text);
+}
+
+void MultiFlashDialog::flasher_progress(int index, int value, int max)
+{
+    QProgressBar *bar = (QProgressBar *)ui->tableWidget->cellWidget(index, 2);
+
+    bar->setRange(0, max);
+    bar->setValue(value);
+}
+
+void MultiFlashDialog::flasher_session_finished(int index, bool ok, qint64 elapsed_ms)
+{
+    Q_UNUSED(ok);
+
+    ui->tableWidget->item(index, 3)->setText(QString::number(elapsed_ms / 1000.0, 'f', 1) + " s");
+}
+
+/**
+ * @brief 全部会话结束, 显示成功数量与折合每小时产能
+*/
+void MultiFlashDialog::flasher_all_finished(int ok_count, int total, qint64 elapsed_ms)
+{
+    double per_hour = 0;
+    if(elapsed_ms > 0)
+        per_hour = ok_count * 3600000.0 / elapsed_ms;
+
+    ui->label_2->setText(QString("成功 %1 / %2, 用时 %3 s, 折合 %4 块/小时")
+                         .arg(ok_count).arg(total)
+                         .arg(elapsed_ms / 1000.0, 0, 'f', 1)
+                         .arg(per_hour, 0, 'f', 0));
+
+    ui->pushButton->setEnabled(true);
+    ui->pushButton_2->setEnabled(true);
+    ui->pushButton_3->setEnabled(false);
+    ui->listWidget->setEnabled(true);
+}
+
+void MultiFlashDialog::closeEvent(QCloseEvent *event)
+{
+    if(flasher->is_running())
+        flasher->stop();
+
+    event->accept();
+}
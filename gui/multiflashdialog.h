@@ -0,0 +1,45 @@
+#ifndef MULTIFLASHDIALOG_H
+#define MULTIFLASHDIALOG_H
+
+#include <QDialog>
+#include "multiflasher.h"
+
+namespace Ui {
+class MultiFlashDialog;
+}
+
+/**
+ * @brief 批量烧写窗口, 每个串口的状态显示在表格中的一行
+ */
+class MultiFlashDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit MultiFlashDialog(QString file_path, int baudrate, int window, int max_baud,
+                              int max_frame, bool skip_blank, bool compress, bool resume, QWidget *parent = 0);
+    ~MultiFlashDialog();
+
+private slots:
+    void on_pushButton_clicked();
+    void on_pushButton_2_clicked();
+    void on_pushButton_3_clicked();
+
+    void flasher_state(int index, int state, QString msg);
+    void flasher_progress(int index, int value, int max);
+    void flasher_session_finished(int index, bool ok, qint64 elapsed_ms);
+    void flasher_all_finished(int ok_count, int total, qint64 elapsed_ms);
+
+private:
+    Ui::MultiFlashDialog *ui;
+    MultiFlasher *flasher;
+
+    QString file_path;
+    int baudrate;
+    int window;
+
+    void scan_serial_port(void);
+    void closeEvent(QCloseEvent *event);
+};
+
+#endif // MULTIFLASHDIALOG_H
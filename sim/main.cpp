@@ -0,0 +1,121 @@
+#include "ptysim.h"
+#include "protocol.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <signal.h>
+#include <stdio.h>
+
+static void on_signal(int sig)
+{
+    Q_UNUSED(sig);
+    QCoreApplication::exit(0);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCommandLineParser parser;
+    PtySim pty;
+
+    parser.setApplicationDescription("OrangeBoot bootloader simulator on a pseudo-terminal");
+    parser.addHelpOption();
+
+    QCommandLineOption link_opt(QStringList() << "l" << "link", "Create a symlink to the pty slave.", "path");
+    QCommandLineOption fw_size_opt("fw-size", "Firmware area size in bytes.", "bytes");
+    QCommandLineOption strc_opt("flash-strc", "Flash structure string.", "text");
+    QCommandLineOption max_baud_opt("max-baud", "Highest baud rate accepted by SET_BAUD.", "rate");
+    QCommandLineOption legacy_opt("legacy", "Do not answer GET_CAPS or GET_FRAME_MAX (no compressed or long frames).");
+    QCommandLineOption frame_max_opt("frame-max", "Largest program frame payload reported by GET_FRAME_MAX, 0 for none.", "bytes");
+    QCommandLineOption no_emu_opt("no-baud-emu", "Do not emulate line timing or baud mismatch.");
+    QCommandLineOption latency_opt("latency", "Default command processing time.", "us");
+    QCommandLineOption cmd_latency_opt("cmd-latency", "Processing time of one command, repeatable.", "cmd=us");
+    QCommandLineOption erase_opt("erase-time", "Chip erase time.", "ms");
+    QCommandLineOption sector_erase_opt("sector-erase-time", "Sector erase time.", "ms");
+    QCommandLineOption drop_opt("drop", "Probability of dropping a reply.", "p");
+    QCommandLineOption corrupt_opt("corrupt", "Probability of flipping a bit in a reply.", "p");
+    QCommandLineOption fail_opt("fail", "Probability of answering FAILED.", "p");
+    QCommandLineOption seed_opt("seed", "Random seed for fault injection.", "n");
+    QCommandLineOption verbose_opt(QStringList() << "v" << "verbose", "Log baud switches and injected faults.");
+
+    parser.addOption(link_opt);
+    parser.addOption(fw_size_opt);
+    parser.addOption(strc_opt);
+    parser.addOption(max_baud_opt);
+    parser.addOption(legacy_opt);
+    parser.addOption(frame_max_opt);
+    parser.addOption(no_emu_opt);
+    parser.addOption(latency_opt);
+    parser.addOption(cmd_latency_opt);
+    parser.addOption(erase_opt);
+    parser.addOption(sector_erase_opt);
+    parser.addOption(drop_opt);
+    parser.addOption(corrupt_opt);
+    parser.addOption(fail_opt);
+    parser.addOption(seed_opt);
+    parser.addOption(verbose_opt);
+    parser.process(a);
+
+    BootloaderSim *dev = pty.device();
+
+    if(parser.isSet(strc_opt))
+        dev->set_flash_strc(parser.value(strc_opt).toLatin1());
+    if(parser.isSet(fw_size_opt))
+        dev->set_fw_size(parser.value(fw_size_opt).toUInt());
+    if(parser.isSet(max_baud_opt))
+        dev->set_max_baudrate(parser.value(max_baud_opt).toInt());
+    if(parser.isSet(frame_max_opt))
+        dev->set_frame_max(qMin(parser.value(frame_max_opt).toUInt(), (uint)SIM_ARGS_MAX - 1));
+    if(parser.isSet(legacy_opt))
+    {
+        dev->set_caps(0, 0);
+        dev->set_frame_max(0);
+    }
+
+    pty.set_emulate_baud(!parser.isSet(no_emu_opt));
+    if(parser.isSet(latency_opt))
+        pty.set_latency(parser.value(latency_opt).toInt());
+    if(parser.isSet(erase_opt))
+        pty.set_erase_time(parser.value(erase_opt).toInt());
+    if(parser.isSet(sector_erase_opt))
+        pty.set_sector_erase_time(parser.value(sector_erase_opt).toInt());
+    if(parser.isSet(drop_opt))
+        pty.set_drop_rate(parser.value(drop_opt).toDouble());
+    if(parser.isSet(corrupt_opt))
+        pty.set_corrupt_rate(parser.value(corrupt_opt).toDouble());
+    if(parser.isSet(fail_opt))
+        pty.set_fail_rate(parser.value(fail_opt).toDouble());
+    if(parser.isSet(seed_opt))
+        pty.set_seed(parser.value(seed_opt).toUInt());
+    pty.set_verbose(parser.isSet(verbose_opt));
+
+    /* 指令可写为十六进制 (0x52) 或十进制 */
+    foreach(const QString &item, parser.values(cmd_latency_opt))
+    {
+        QStringList kv = item.split('=');
+        bool ok1 = false, ok2 = false;
+        int cmd = (kv.size() == 2) ? kv.at(0).toInt(&ok1, 0) : 0;
+        int us = (kv.size() == 2) ? kv.at(1).toInt(&ok2) : 0;
+
+        if(!ok1 || !ok2)
+        {
+            fprintf(stderr, "invalid --cmd-latency %s\n", qPrintable(item));
+            return 1;
+        }
+        pty.set_cmd_latency(cmd, us);
+    }
+
+    if(!pty.open(parser.value(link_opt)))
+    {
+        fprintf(stderr, "%s\n", qPrintable(pty.error_string()));
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    /* 第一行输出从设备名, 供脚本读取 */
+    printf("%s\n", qPrintable(pty.slave_name()));
+    fflush(stdout);
+
+    return a.exec();
+}
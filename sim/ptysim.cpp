@@ -0,0 +1,347 @@
+#include "ptysim.h"
+#include "protocol.h"
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+PtySim::PtySim(QObject *parent) :
+    QObject(parent)
+{
+    master = -1;
+    slave = -1;
+    notifier = NULL;
+
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setTimerType(Qt::PreciseTimer);
+    connect(timer, &QTimer::timeout, this, &PtySim::on_timer);
+
+    rx_head = 0;
+    rx_free = 0;
+    tx_head = 0;
+    tx_free = 0;
+    busy_until = 0;
+
+    line_baud = SIM_BAUD_DEFAULT;
+    next_baud = SIM_BAUD_DEFAULT;
+    switch_time = -1;
+    revert_time = -1;
+
+    emulate_baud = true;
+    latency = PTYSIM_LATENCY;
+    erase_ms = PTYSIM_ERASE_TIME;
+    sector_erase_ms = PTYSIM_SECTOR_ERASE_TIME;
+    drop_rate = 0;
+    corrupt_rate = 0;
+    fail_rate = 0;
+    verbose = false;
+
+    clock.start();
+}
+
+PtySim::~PtySim()
+{
+    if(!link.isEmpty())
+        unlink(link.toLocal8Bit().constData());
+    if(slave >= 0)
+        close(slave);
+    if(master >= 0)
+        close(master);
+}
+
+/**
+* @brief  创建伪终端
+* @param  [in] link_path QString. 指向从设备的符号链接, 为空时不创建
+* @return 是否成功. 失败原因由 error_string 返回
+*/
+bool PtySim::open(const QString &link_path)
+{
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if((master < 0) || (grantpt(master) != 0) || (unlockpt(master) != 0))
+    {
+        error = "无法创建伪终端";
+        return false;
+    }
+
+    slave_path = ptsname(master);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    slave = ::open(slave_path.toLocal8Bit().constData(), O_RDWR | O_NOCTTY);
+    if(slave < 0)
+    {
+        error = "无法打开 " + slave_path;
+        return false;
+    }
+
+    /* 从设备设为原始模式, 主机打开前的默认波特率与设备一致 */
+    struct termios2 t;
+    ioctl(slave, TCGETS2, &t);
+    t.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+    t.c_oflag &= ~OPOST;
+    t.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    t.c_cflag &= ~(CSIZE | PARENB | CBAUD);
+    t.c_cflag |= CS8 | BOTHER;
+    t.c_ispeed = SIM_BAUD_DEFAULT;
+    t.c_ospeed = SIM_BAUD_DEFAULT;
+    ioctl(slave, TCSETS2, &t);
+
+    if(!link_path.isEmpty())
+    {
+        unlink(link_path.toLocal8Bit().constData());
+        if(symlink(slave_path.toLocal8Bit().constData(), link_path.toLocal8Bit().constData()) != 0)
+        {
+            error = "无法创建链接 " + link_path;
+            return false;
+        }
+        link = link_path;
+    }
+
+    notifier = new QSocketNotifier(master, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &PtySim::on_readable);
+    return true;
+}
+
+/**
+ * @brief 一个字节 (起始位 + 8 数据位 + 停止位) 在线路上的时间
+ */
+qint64 PtySim::byte_time(int baud) const
+{
+    if(!emulate_baud || (baud <= 0))
+        return 0;
+
+    return 10000000000LL / baud;
+}
+
+/**
+ * @brief 设备在 t 时刻的波特率
+ */
+int PtySim::baud_at(qint64 t) const
+{
+    if((switch_time >= 0) && (t >= switch_time))
+        return next_baud;
+
+    return line_baud;
+}
+
+/**
+ * @brief 主机在从设备上设置的波特率. 主设备上的 termios 操作作用于从设备
+ */
+int PtySim::host_baud(void) const
+{
+    struct termios2 t;
+
+    if(ioctl(master, TCGETS2, &t) != 0)
+        return 0;
+
+    return t.c_ospeed;
+}
+
+bool PtySim::chance(double p)
+{
+    if(p <= 0)
+        return false;
+
+    return std::uniform_real_distribution<double>(0, 1)(rng) < p;
+}
+
+void PtySim::on_readable(void)
+{
+    char buf[4096];
+    ssize_t len;
+
+    while((len = read(master, buf, sizeof(buf))) > 0)
+    {
+        int baud = host_baud();
+        qint64 t = now();
+
+        for(ssize_t i = 0; i < len; i++)
+        {
+            WireByte b;
+
+            rx_free = qMax(rx_free, t) + byte_time(baud);
+            b.time = rx_free;
+            b.baud = baud;
+            b.c = buf[i];
+            rx.append(b);
+        }
+    }
+
+    on_timer();
+}
+
+void PtySim::on_timer(void)
+{
+    qint64 t = now();
+
+    deliver(t);
+
+    if((switch_time >= 0) && (t >= switch_time))
+    {
+        line_baud = next_baud;
+        switch_time = -1;
+    }
+
+    /* 切换波特率后未在新波特率下收到有效指令, 恢复原波特率 */
+    if((revert_time >= 0) && (t >= revert_time))
+    {
+        revert_time = -1;
+        if(sim.baud_unconfirmed())
+        {
+            sim.revert_baud();
+            line_baud = sim.baudrate();
+            if(verbose)
+                fprintf(stderr, "baud reverted to %d\n", line_baud);
+        }
+    }
+
+    flush(t);
+    schedule();
+}
+
+/**
+ * @brief 把 t 时刻之前到达的字节交给设备, 完成的指令按处理时间生成应答
+ */
+void PtySim::deliver(qint64 t)
+{
+    while((rx_head < rx.size()) && (rx.at(rx_head).time <= t))
+    {
+        WireByte b = rx.at(rx_head++);
+        QByteArray out;
+        int cmd;
+
+        /* 波特率不一致, 设备收到的是乱码, 丢弃 */
+        if(emulate_baud && (b.baud > 0) && (b.baud != baud_at(b.time)))
+            continue;
+
+        if(!sim.input((unsigned char)b.c, &out, &cmd))
+            continue;
+
+        int us;
+        if(cmd == PROTO_CHIP_ERASE)
+            us = erase_ms * 1000;
+        else if(cmd == PROTO_SECTOR_ERASE)
+            us = sector_erase_ms * 1000;
+        else
+            us = cmd_latency.value(cmd, latency);
+
+        busy_until = qMax(b.time, busy_until) + (qint64)us * 1000;
+        reply(cmd, out, busy_until);
+    }
+
+    if(rx_head == rx.size())
+    {
+        rx.clear();
+        rx_head = 0;
+    }
+}
+
+/**
+ * @brief 按波特率排队发送应答, 并按概率注入故障
+ * @param [in] cmd int. 指令
+ * @param [in] data QByteArray. 应答
+ * @param [in] t qint64. 应答开始发送的时刻
+ */
+void PtySim::reply(int cmd, QByteArray data, qint64 t)
+{
+    /* 切换波特率的应答不注入失败, 否则设备与主机的状态不一致 */
+    if((cmd != PROTO_GET_SYNC) && (cmd != PROTO_SET_BAUD) && chance(fail_rate))
+    {
+        data.clear();
+        data.append((char)PROTO_INSYNC);
+        data.append((char)PROTO_FAILED);
+        if(verbose)
+            fprintf(stderr, "cmd 0x%02X: inject failure\n", cmd);
+    }
+
+    if(chance(drop_rate))
+    {
+        if(verbose)
+            fprintf(stderr, "cmd 0x%02X: drop reply\n", cmd);
+        data.clear();
+    }
+
+    if(!data.isEmpty() && chance(corrupt_rate))
+    {
+        int pos = rng() % data.size();
+        data[pos] = data.at(pos) ^ (char)(1 << (rng() % 8));
+        if(verbose)
+            fprintf(stderr, "cmd 0x%02X: corrupt byte %d\n", cmd, pos);
+    }
+
+    int baud = baud_at(t);
+    for(int i = 0; i < data.size(); i++)
+    {
+        WireByte b;
+
+        tx_free = qMax(tx_free, t) + byte_time(baud);
+        b.time = tx_free;
+        b.baud = baud;
+        b.c = data.at(i);
+        tx.append(b);
+    }
+
+    /* 应答发送完后切换波特率 */
+    if((cmd == PROTO_SET_BAUD) && sim.baud_unconfirmed())
+    {
+        next_baud = sim.baudrate();
+        switch_time = qMax(tx_free, t);
+        revert_time = switch_time + (qint64)PROTO_BAUD_REVERT_TIME * 1000000;
+        if(verbose)
+            fprintf(stderr, "baud %d -> %d\n", line_baud, next_baud);
+    }
+}
+
+/**
+ * @brief 写出 t 时刻之前到达主机的字节, 主机波特率不一致的字节丢弃
+ */
+void PtySim::flush(qint64 t)
+{
+    QByteArray out;
+    int baud = host_baud();
+
+    while((tx_head < tx.size()) && (tx.at(tx_head).time <= t))
+    {
+        const WireByte &b = tx.at(tx_head++);
+
+        if(!emulate_baud || (baud <= 0) || (b.baud == baud))
+            out.append(b.c);
+    }
+
+    if(tx_head == tx.size())
+    {
+        tx.clear();
+        tx_head = 0;
+    }
+
+    if(!out.isEmpty() && (write(master, out.constData(), out.size()) != out.size()) && verbose)
+        fprintf(stderr, "pty write overflow\n");
+}
+
+/**
+ * @brief 定时到下一个事件
+ */
+void PtySim::schedule(void)
+{
+    qint64 next = -1;
+
+    if(rx_head < rx.size())
+        next = rx.at(rx_head).time;
+    if((tx_head < tx.size()) && ((next < 0) || (tx.at(tx_head).time < next)))
+        next = tx.at(tx_head).time;
+    if((switch_time >= 0) && ((next < 0) || (switch_time < next)))
+        next = switch_time;
+    if((revert_time >= 0) && ((next < 0) || (revert_time < next)))
+        next = revert_time;
+
+    if(next < 0)
+    {
+        timer->stop();
+        return;
+    }
+
+    qint64 wait = next - now();
+    timer->start((wait <= 0) ? 0 : (int)((wait + 999999) / 1000000));
+}
@@ -0,0 +1,106 @@
+#ifndef PTYSIM_H
+#define PTYSIM_H
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <random>
+#include "bootloadersim.h"
+
+#define PTYSIM_LATENCY              50              /*!< 默认指令处理时间, 单位 us */
+#define PTYSIM_ERASE_TIME           500             /*!< 默认整片擦除时间, 单位 ms */
+#define PTYSIM_SECTOR_ERASE_TIME    50              /*!< 默认扇区擦除时间, 单位 ms */
+
+/**
+ * @brief 经伪终端提供的虚拟 bootloader
+ * @note  主机打开伪终端的从设备, 与真实串口一样使用. 本对象在主设备一侧按波特率逐字节收发,
+ *        模拟指令处理时间与擦除时间, 并可按概率注入故障. 内部时间单位为 ns
+ */
+class PtySim : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PtySim(QObject *parent = 0);
+    ~PtySim();
+
+    bool open(const QString &link_path);
+    QString slave_name(void) const { return slave_path; }
+    QString error_string(void) const { return error; }
+    BootloaderSim *device(void) { return &sim; }
+
+    void set_emulate_baud(bool enable) { emulate_baud = enable; }
+    void set_latency(int us) { latency = us; }
+    void set_cmd_latency(int cmd, int us) { cmd_latency.insert(cmd, us); }
+    void set_erase_time(int ms) { erase_ms = ms; }
+    void set_sector_erase_time(int ms) { sector_erase_ms = ms; }
+    void set_drop_rate(double p) { drop_rate = p; }
+    void set_corrupt_rate(double p) { corrupt_rate = p; }
+    void set_fail_rate(double p) { fail_rate = p; }
+    void set_seed(uint seed) { rng.seed(seed); }
+    void set_verbose(bool enable) { verbose = enable; }
+
+private slots:
+    void on_readable(void);
+    void on_timer(void);
+
+private:
+    /**
+     * @brief 线路上的一个字节
+     */
+    struct WireByte
+    {
+        qint64 time;        /*!< 到达对端的时刻 */
+        int baud;           /*!< 发送方的波特率, 与接收方不一致时对端收到的是乱码 */
+        char c;
+    };
+
+    int master;
+    int slave;                              /*!< 保持从设备打开, 主机关闭串口时主设备不会读到 EIO */
+    QString slave_path;
+    QString link;
+    QString error;
+    QSocketNotifier *notifier;
+    QTimer *timer;
+    QElapsedTimer clock;
+    BootloaderSim sim;
+
+    QVector<WireByte> rx;                   /*!< 主机已发出, 尚未到达设备的字节 */
+    int rx_head;
+    qint64 rx_free;                         /*!< 接收线路空闲的时刻 */
+    QVector<WireByte> tx;                   /*!< 设备已发出, 尚未到达主机的字节 */
+    int tx_head;
+    qint64 tx_free;
+    qint64 busy_until;                      /*!< 设备处理完上一条指令的时刻 */
+
+    int line_baud;                          /*!< 设备当前的波特率 */
+    int next_baud;                          /*!< PROTO_SET_BAUD 应答发完后切换到的波特率 */
+    qint64 switch_time;                     /*!< 切换时刻, 无切换时为 -1 */
+    qint64 revert_time;                     /*!< 检查是否恢复原波特率的时刻, 无时为 -1 */
+
+    bool emulate_baud;
+    int latency;                            /*!< 默认指令处理时间, 单位 us */
+    QHash<int, int> cmd_latency;            /*!< 各指令的处理时间, 单位 us */
+    int erase_ms;
+    int sector_erase_ms;
+    double drop_rate;
+    double corrupt_rate;
+    double fail_rate;
+    std::mt19937 rng;
+    bool verbose;
+
+    qint64 now(void) const { return clock.nsecsElapsed(); }
+    qint64 byte_time(int baud) const;
+    int baud_at(qint64 t) const;
+    int host_baud(void) const;
+    bool chance(double p);
+    void deliver(qint64 t);
+    void reply(int cmd, QByteArray data, qint64 t);
+    void flush(qint64 t);
+    void schedule(void);
+};
+
+#endif // PTYSIM_H
@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# 虚拟 bootloader, 经伪终端提供, 用于无硬件的测试与性能评估 (仅 Linux)
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = OrangeBootSim
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../core/core.pri)
+
+SOURCES += \
+        main.cpp \
+        ptysim.cpp
+
+HEADERS += \
+        ptysim.h
@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# CRC32 各实现与逐位计算的对比测试
+#
+#-------------------------------------------------
+
+QT       += core
+QT       += testlib
+QT       -= gui
+
+TARGET = tst_crc32
+TEMPLATE = app
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../core/core.pri)
+
+SOURCES += \
+        tst_crc32.cpp
@@ -0,0 +1,171 @@
+#include <QtTest>
+#include "crc32.h"
+
+#define TEST_BUF_SIZE               (4096 + 64)     /*!< 测试数据长度, 含起始偏移的余量 */
+#define TEST_ROUNDS                 2000            /*!< 随机长度与偏移的测试次数 */
+
+/**
+ * @brief 逐位计算的参考实现, 与 bootloader 相同的多项式与反射方式
+ */
+static uint crc32_bitwise(const unsigned char *p, size_t len, uint state)
+{
+    while(len--)
+    {
+        state ^= *p++;
+        for(int i = 0; i < 8; i++)
+            state = (state & 1) ? ((state >> 1) ^ 0xedb88320U) : (state >> 1);
+    }
+
+    return state;
+}
+
+/**
+ * @brief 逐字节追加相同字节的参考实现
+ */
+static uint crc32_fill_loop(unsigned char value, size_t count, uint state)
+{
+    while(count--)
+        state = crc32_bitwise(&value, 1, state);
+
+    return state;
+}
+
+/**
+ * @brief 固定种子的伪随机数 (xorshift32), 失败时可复现
+ */
+static uint next_rand(uint *seed)
+{
+    uint x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+class Crc32Test : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase(void);
+    void short_lengths(void);
+    void random_spans(void);
+    void chained(void);
+    void fill(void);
+    void combine(void);
+
+private:
+    unsigned char buf[TEST_BUF_SIZE];
+};
+
+void Crc32Test::initTestCase(void)
+{
+    uint seed = 0x12345678;
+
+    for(int i = 0; i < TEST_BUF_SIZE; i++)
+        buf[i] = next_rand(&seed) >> 24;
+
+    qDebug() << "PCLMULQDQ" << (crc32_accelerated() ? "enabled" : "not available");
+}
+
+/**
+ * @brief 0~256 字节的所有长度与 0~15 的所有起始偏移, 覆盖查表法与 PCLMUL 的尾部处理
+ */
+void Crc32Test::short_lengths(void)
+{
+    for(int offset = 0; offset < 16; offset++)
+    {
+        for(int len = 0; len <= 256; len++)
+        {
+            uint ref = crc32_bitwise(buf + offset, len, 0);
+
+            QCOMPARE(crc32_generic(buf + offset, len, 0), ref);
+            QCOMPARE(crc32(buf + offset, len, 0), ref);
+        }
+    }
+}
+
+/**
+ * @brief 随机长度 (0~4096), 随机起始偏移与随机初值
+ */
+void Crc32Test::random_spans(void)
+{
+    uint seed = 0xcafe1234;
+
+    for(int i = 0; i < TEST_ROUNDS; i++)
+    {
+        size_t len = next_rand(&seed) % 4097;
+        size_t offset = next_rand(&seed) % 64;
+        uint state = next_rand(&seed);
+        uint ref = crc32_bitwise(buf + offset, len, state);
+
+        QCOMPARE(crc32_generic(buf + offset, len, state), ref);
+        QCOMPARE(crc32(buf + offset, len, state), ref);
+    }
+}
+
+/**
+ * @brief 分段计算的结果与整体计算相同
+ */
+void Crc32Test::chained(void)
+{
+    uint seed = 0x0badf00d;
+
+    for(int i = 0; i < TEST_ROUNDS; i++)
+    {
+        size_t len = next_rand(&seed) % 4097;
+        size_t split = len ? next_rand(&seed) % (len + 1) : 0;
+        uint ref = crc32_bitwise(buf, len, 0);
+
+        QCOMPARE(crc32(buf + split, len - split, crc32(buf, split, 0)), ref);
+    }
+}
+
+/**
+ * @brief 追加相同字节与逐字节循环的结果相同
+ */
+void Crc32Test::fill(void)
+{
+    static const unsigned char values[] = {0xff, 0x00, 0x5a};
+    uint seed = 0xdeadbeef;
+
+    for(size_t v = 0; v < sizeof(values); v++)
+    {
+        for(size_t count = 0; count <= 300; count++)
+        {
+            uint state = next_rand(&seed);
+            QCOMPARE(crc32_fill(values[v], count, state), crc32_fill_loop(values[v], count, state));
+        }
+
+        for(int i = 0; i < 20; i++)
+        {
+            size_t count = next_rand(&seed) % (1024 * 1024);
+            uint state = next_rand(&seed);
+            QCOMPARE(crc32_fill(values[v], count, state), crc32_fill_loop(values[v], count, state));
+        }
+    }
+}
+
+/**
+ * @brief 合并两段的CRC与整体计算相同
+ */
+void Crc32Test::combine(void)
+{
+    uint seed = 0x600dcafe;
+
+    for(int i = 0; i < TEST_ROUNDS; i++)
+    {
+        size_t len = next_rand(&seed) % 4097;
+        size_t split = len ? next_rand(&seed) % (len + 1) : 0;
+        uint crc1 = crc32_bitwise(buf, split, 0);
+        uint crc2 = crc32_bitwise(buf + split, len - split, 0);
+
+        QCOMPARE(crc32_combine(crc1, crc2, len - split), crc32_bitwise(buf, len, 0));
+    }
+}
+
+QTEST_APPLESS_MAIN(Crc32Test)
+
+#include "tst_crc32.moc"
@@ -0,0 +1,10 @@
+#-------------------------------------------------
+#
+# 单元测试, 在构建目录下运行 make check
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    crc32